@@ -29,9 +29,10 @@ int main(int argc, char *argv[])
     qDebug() << "You can also iterate through all addresses in a given prefix, e.g. " << prefix
              << ":";
 
-    /*QHostAddress next;
-    while (prefix.hasMoreAddresses()) {
-        next = prefix.nextAddress();
+    /*NetworkAddressCursor cursor(prefix);
+    QHostAddress next;
+    while (cursor.hasMoreAddresses()) {
+        next = cursor.nextAddress();
         qDebug() << next;
     }*/
 
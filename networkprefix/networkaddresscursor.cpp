@@ -0,0 +1,135 @@
+#include "networkaddresscursor.h"
+
+#include <networkprefix.h>
+
+/**
+ * @brief NetworkAddressCursor::NetworkAddressCursor
+ */
+
+NetworkAddressCursor::NetworkAddressCursor()
+: m_position(0)
+{
+}
+
+/**
+ * @brief NetworkAddressCursor::NetworkAddressCursor
+ * @param prefix
+ */
+
+NetworkAddressCursor::NetworkAddressCursor(const NetworkPrefix &prefix)
+: m_range(prefix.toRange())
+, m_position(0)
+{
+}
+
+/**
+ * @brief NetworkAddressCursor::NetworkAddressCursor
+ * @param range
+ */
+
+NetworkAddressCursor::NetworkAddressCursor(const NetworkAddressRange &range)
+: m_range(range)
+, m_position(0)
+{
+}
+
+/**
+ * @brief NetworkAddressCursor::nextAddress
+ * @return 
+ */
+
+QHostAddress NetworkAddressCursor::nextAddress()
+{
+    if (!hasMoreAddresses()) {
+        return QHostAddress();
+    }
+
+    const QHostAddress address = m_range.addressAt(m_position);
+    ++m_position;
+
+    return address;
+}
+
+/**
+ * @brief NetworkAddressCursor::hasMoreAddresses
+ * @return 
+ */
+
+bool NetworkAddressCursor::hasMoreAddresses() const
+{
+    return m_position < m_range.addressCount();
+}
+
+/**
+ * @brief NetworkAddressCursor::resetIterator
+ */
+
+void NetworkAddressCursor::resetIterator()
+{
+    m_position = 0;
+}
+
+/**
+ * @brief NetworkAddressCursor::nextAddresses
+ * @param addresses
+ * @param count
+ * @return 
+ */
+
+int NetworkAddressCursor::nextAddresses(quint32 *addresses, int count)
+{
+    if (!m_range.isIpv4() || count <= 0) {
+        return 0;
+    }
+
+    const quint64 remaining = (m_range.addressCount() - m_position).lo;
+    const int n = remaining < static_cast<quint64>(count) ? static_cast<int>(remaining) : count;
+    const quint32 base = static_cast<quint32>(m_range.rawFirst().lo + m_position.lo);
+
+    for (int i = 0; i < n; ++i) {
+        addresses[i] = base + static_cast<quint32>(i);
+    }
+
+    m_position += static_cast<quint64>(n);
+    return n;
+}
+
+int NetworkAddressCursor::nextAddresses(Q_IPV6ADDR *addresses, int count)
+{
+    if (!m_range.isIpv6() || count <= 0) {
+        return 0;
+    }
+
+    const UInt128 remaining = m_range.addressCount() - m_position;
+    const int n = remaining < UInt128(static_cast<quint64>(count)) ? static_cast<int>(remaining.lo)
+                                                                  : count;
+    UInt128 address = m_range.rawFirst() + m_position;
+
+    for (int i = 0; i < n; ++i) {
+        address.toBytes(addresses[i].c);
+        ++address;
+    }
+
+    m_position += static_cast<quint64>(n);
+    return n;
+}
+
+/**
+ * @brief NetworkAddressCursor::range
+ * @return 
+ */
+
+NetworkAddressRange NetworkAddressCursor::range() const
+{
+    return m_range;
+}
+
+/**
+ * @brief NetworkAddressCursor::position
+ * @return 
+ */
+
+UInt128 NetworkAddressCursor::position() const
+{
+    return m_position;
+}
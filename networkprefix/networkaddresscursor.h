@@ -0,0 +1,43 @@
+/**
+ * Walks the addresses of a NetworkPrefix or a NetworkAddressRange in
+ * ascending order.
+ *
+ * Prefixes and ranges are plain values without any iteration state, so one
+ * const instance can be shared by any number of threads. Each of them
+ * iterates with a cursor of its own; a cursor keeps a copy of the range and
+ * its position, nothing else.
+ */
+
+#ifndef NETWORKADDRESSCURSOR_H
+#define NETWORKADDRESSCURSOR_H
+
+#include <networkaddressrange.h>
+
+class NetworkAddressCursor
+{
+public:
+    explicit NetworkAddressCursor();
+    explicit NetworkAddressCursor(const NetworkPrefix &prefix);
+    explicit NetworkAddressCursor(const NetworkAddressRange &range);
+
+    QHostAddress nextAddress();
+    bool hasMoreAddresses() const;
+    void resetIterator();
+
+    //write up to count of the next addresses in host byte order into the
+    //buffer, returns how many were written; 0 if the family does not match
+    int nextAddresses(quint32 *addresses, int count);
+    int nextAddresses(Q_IPV6ADDR *addresses, int count);
+
+    NetworkAddressRange range() const;
+    //the number of addresses handed out so far
+    UInt128 position() const;
+
+private:
+    NetworkAddressRange m_range;
+    UInt128 m_position;
+};
+
+Q_DECLARE_TYPEINFO(NetworkAddressCursor, Q_PRIMITIVE_TYPE);
+
+#endif // NETWORKADDRESSCURSOR_H
@@ -0,0 +1,218 @@
+#include "networkaddresspermutation.h"
+#include "prefixmath.h"
+
+#include <algorithm>
+
+/**
+ * @brief NetworkAddressPermutation::NetworkAddressPermutation
+ */
+
+NetworkAddressPermutation::NetworkAddressPermutation()
+: NetworkAddressPermutation(QVector<NetworkAddressRange>(), 0)
+{
+}
+
+/**
+ * @brief NetworkAddressPermutation::NetworkAddressPermutation
+ * @param range
+ * @param seed
+ */
+
+NetworkAddressPermutation::NetworkAddressPermutation(const NetworkAddressRange &range, quint64 seed)
+: NetworkAddressPermutation(QVector<NetworkAddressRange>() << range, seed)
+{
+}
+
+/**
+ * @brief NetworkAddressPermutation::NetworkAddressPermutation
+ * @param ranges
+ * @param seed
+ */
+
+NetworkAddressPermutation::NetworkAddressPermutation(const QVector<NetworkAddressRange> &ranges,
+                                                     quint64 seed)
+: m_totalCount(0)
+, m_halfBits(1)
+{
+    for (const NetworkAddressRange &range : ranges) {
+        if (!range.isValid()) {
+            continue;
+        }
+
+        const UInt128 offset = m_totalCount;
+        m_totalCount += range.addressCount();
+
+        //only reachable with the whole IPv6 space, that one is cut short
+        if (m_totalCount < offset) {
+            m_totalCount = UInt128::max();
+        }
+
+        m_ranges.append(range);
+        m_offsets.append(offset);
+    }
+
+    //the smallest even number of bits that holds every index
+    if (m_totalCount > 1) {
+        const int bits = 128 - (m_totalCount - 1).countLeadingZeroBits();
+        m_halfBits = qMax(1, (bits + 1) / 2);
+    }
+
+    quint64 state = seed;
+    for (int i = 0; i < Rounds; ++i) {
+        state += Q_UINT64_C(0x9e3779b97f4a7c15);
+        m_roundKeys[i] = PrefixMath::mix(state);
+    }
+
+    m_begin = 0;
+    m_end = m_totalCount;
+    m_current = 0;
+}
+
+/**
+ * @brief NetworkAddressPermutation::nextAddress
+ * @return 
+ */
+
+QHostAddress NetworkAddressPermutation::nextAddress()
+{
+    if (!hasMoreAddresses()) {
+        return QHostAddress();
+    }
+
+    const QHostAddress address = addressAtIndex(permute(m_current));
+    ++m_current;
+
+    return address;
+}
+
+/**
+ * @brief NetworkAddressPermutation::hasMoreAddresses
+ * @return 
+ */
+
+bool NetworkAddressPermutation::hasMoreAddresses() const
+{
+    return m_current < m_end;
+}
+
+/**
+ * @brief NetworkAddressPermutation::resetIterator
+ */
+
+void NetworkAddressPermutation::resetIterator()
+{
+    m_current = m_begin;
+}
+
+/**
+ * @brief NetworkAddressPermutation::addressCount
+ * @return 
+ */
+
+UInt128 NetworkAddressPermutation::addressCount() const
+{
+    return m_end - m_begin;
+}
+
+/**
+ * @brief NetworkAddressPermutation::addressAt
+ * @param position
+ * @return 
+ */
+
+QHostAddress NetworkAddressPermutation::addressAt(const UInt128 &position) const
+{
+    if (position >= addressCount()) {
+        return QHostAddress();
+    }
+
+    return addressAtIndex(permute(m_begin + position));
+}
+
+/**
+ * @brief NetworkAddressPermutation::split
+ * @param count
+ * @return 
+ */
+
+QVector<NetworkAddressPermutation> NetworkAddressPermutation::split(int count) const
+{
+    QVector<NetworkAddressPermutation> slices;
+
+    if (count <= 0) {
+        return slices;
+    }
+
+    //same balancing as NetworkAddressRange::split(), the ranges are shared
+    //between the slices, only the window into the sequence differs
+    UInt128 remainder;
+    const UInt128 size = UInt128::divide(addressCount(), static_cast<quint64>(count), &remainder);
+    UInt128 begin = m_begin;
+
+    for (int i = 0; i < count; ++i) {
+        UInt128 length = size;
+        if (UInt128(static_cast<quint64>(i)) < remainder) {
+            ++length;
+        }
+
+        if (length.isZero()) {
+            break;
+        }
+
+        NetworkAddressPermutation slice = *this;
+        slice.m_begin = begin;
+        slice.m_end = begin + length;
+        slice.m_current = begin;
+        slices.append(slice);
+
+        begin += length;
+    }
+
+    return slices;
+}
+
+/**
+ * @brief NetworkAddressPermutation::permute
+ * @param index
+ * @return 
+ */
+
+UInt128 NetworkAddressPermutation::permute(const UInt128 &index) const
+{
+    if (m_totalCount <= 1) {
+        return index;
+    }
+
+    //cycle walking: the network permutes a domain of up to four times the
+    //count, so just keep going until we are back inside
+    UInt128 value = encrypt(index);
+    while (value >= m_totalCount) {
+        value = encrypt(value);
+    }
+
+    return value;
+}
+
+UInt128 NetworkAddressPermutation::encrypt(const UInt128 &value) const
+{
+    const quint64 mask = m_halfBits == 64 ? ~quint64(0) : (Q_UINT64_C(1) << m_halfBits) - 1;
+    quint64 left = (value >> m_halfBits).lo & mask;
+    quint64 right = value.lo & mask;
+
+    for (int i = 0; i < Rounds; ++i) {
+        const quint64 next = left ^ (PrefixMath::mix(right ^ m_roundKeys[i]) & mask);
+        left = right;
+        right = next;
+    }
+
+    return (UInt128(left) << m_halfBits) | UInt128(right);
+}
+
+QHostAddress NetworkAddressPermutation::addressAtIndex(const UInt128 &index) const
+{
+    //the last range that starts at or before the index
+    const auto it = std::upper_bound(m_offsets.constBegin(), m_offsets.constEnd(), index);
+    const int range = static_cast<int>(it - m_offsets.constBegin()) - 1;
+
+    return m_ranges[range].addressAt(index - m_offsets[range]);
+}
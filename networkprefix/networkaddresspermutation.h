@@ -0,0 +1,61 @@
+/**
+ * Visits the addresses of one or more ranges exactly once, in a seeded
+ * pseudo-random order, without materializing them.
+ *
+ * The order comes from a bijection on [0, addressCount()): a balanced Feistel
+ * network over the smallest even number of bits that can hold the count,
+ * keyed from the seed. Results outside of the range are fed through the
+ * network again (cycle walking) until they land inside, which on average takes
+ * less than four passes, as the domain is less than four times the count.
+ * Memory is O(number of ranges), independent of the number of addresses.
+ *
+ * split() cuts the permuted sequence into contiguous slices, one per worker
+ * thread. The slices are disjoint and together visit every address once, in
+ * the same order a single unsplit permutation would.
+ */
+
+#ifndef NETWORKADDRESSPERMUTATION_H
+#define NETWORKADDRESSPERMUTATION_H
+
+#include <networkaddressrange.h>
+
+class NetworkAddressPermutation
+{
+public:
+    explicit NetworkAddressPermutation();
+    explicit NetworkAddressPermutation(const NetworkAddressRange &range, quint64 seed);
+    explicit NetworkAddressPermutation(const QVector<NetworkAddressRange> &ranges, quint64 seed);
+
+    QHostAddress nextAddress();
+    bool hasMoreAddresses() const;
+    void resetIterator();
+
+    //the number of addresses in this slice, the whole permutation if not split
+    UInt128 addressCount() const;
+    //the position-th address of this slice in permuted order
+    QHostAddress addressAt(const UInt128 &position) const;
+
+    QVector<NetworkAddressPermutation> split(int count) const;
+
+    //the bijection itself, maps an index below the total count to another one
+    UInt128 permute(const UInt128 &index) const;
+
+private:
+    static const int Rounds = 6;
+
+    UInt128 encrypt(const UInt128 &value) const;
+    QHostAddress addressAtIndex(const UInt128 &index) const;
+
+    QVector<NetworkAddressRange> m_ranges;
+    QVector<UInt128> m_offsets; //index of the first address of each range
+    UInt128 m_totalCount;
+    UInt128 m_begin;
+    UInt128 m_end;
+    UInt128 m_current;
+    quint64 m_roundKeys[Rounds];
+    int m_halfBits;
+};
+
+Q_DECLARE_METATYPE(NetworkAddressPermutation);
+
+#endif // NETWORKADDRESSPERMUTATION_H
@@ -0,0 +1,375 @@
+#include "networkaddressrange.h"
+
+#include <networkprefix.h>
+
+/**
+ * @brief NetworkAddressRange::NetworkAddressRange
+ */
+
+NetworkAddressRange::NetworkAddressRange()
+: m_family(NullFamily)
+{
+}
+
+/**
+ * @brief NetworkAddressRange::NetworkAddressRange
+ * @param first
+ * @param last
+ */
+
+NetworkAddressRange::NetworkAddressRange(QHostAddress first, QHostAddress last)
+: m_family(NullFamily)
+{
+    if (first.protocol() != last.protocol()) {
+        return;
+    }
+
+    if (first.protocol() == QAbstractSocket::IPv4Protocol) {
+        *this = fromIpv4(first.toIPv4Address(), last.toIPv4Address());
+    } else if (first.protocol() == QAbstractSocket::IPv6Protocol) {
+        const Q_IPV6ADDR firstBytes = first.toIPv6Address();
+        const Q_IPV6ADDR lastBytes = last.toIPv6Address();
+        *this = fromIpv6(UInt128::fromBytes(firstBytes.c), UInt128::fromBytes(lastBytes.c));
+    }
+}
+
+/**
+ * @brief NetworkAddressRange::fromIpv4
+ * @param first
+ * @param last
+ * @return 
+ */
+
+NetworkAddressRange NetworkAddressRange::fromIpv4(quint32 first, quint32 last)
+{
+    NetworkAddressRange range;
+
+    if (first > last) {
+        return range;
+    }
+
+    range.m_first = first;
+    range.m_last = last;
+    range.m_family = Ipv4Family;
+
+    return range;
+}
+
+/**
+ * @brief NetworkAddressRange::fromIpv6
+ * @param first
+ * @param last
+ * @return 
+ */
+
+NetworkAddressRange NetworkAddressRange::fromIpv6(const UInt128 &first, const UInt128 &last)
+{
+    NetworkAddressRange range;
+
+    if (first > last) {
+        return range;
+    }
+
+    range.m_first = first;
+    range.m_last = last;
+    range.m_family = Ipv6Family;
+
+    return range;
+}
+
+/**
+ * @brief NetworkAddressRange::first
+ * @return 
+ */
+
+QHostAddress NetworkAddressRange::first() const
+{
+    return toHostAddress(m_first);
+}
+
+/**
+ * @brief NetworkAddressRange::last
+ * @return 
+ */
+
+QHostAddress NetworkAddressRange::last() const
+{
+    return toHostAddress(m_last);
+}
+
+/**
+ * @brief NetworkAddressRange::rawFirst
+ * @return 
+ */
+
+UInt128 NetworkAddressRange::rawFirst() const
+{
+    return m_first;
+}
+
+/**
+ * @brief NetworkAddressRange::rawLast
+ * @return 
+ */
+
+UInt128 NetworkAddressRange::rawLast() const
+{
+    return m_last;
+}
+
+/**
+ * @brief NetworkAddressRange::addressCount
+ * @return 
+ */
+
+UInt128 NetworkAddressRange::addressCount() const
+{
+    if (!isValid()) {
+        return 0;
+    }
+
+    const UInt128 count = m_last - m_first + 1;
+
+    //only the whole IPv6 address space wraps around to zero
+    return count.isZero() ? UInt128::max() : count;
+}
+
+/**
+ * @brief NetworkAddressRange::containsAddress
+ * @param address
+ * @return 
+ */
+
+bool NetworkAddressRange::containsAddress(QHostAddress address) const
+{
+    if (isIpv4() && address.protocol() == QAbstractSocket::IPv4Protocol) {
+        const UInt128 raw = address.toIPv4Address();
+        return m_first <= raw && raw <= m_last;
+    }
+
+    if (isIpv6() && address.protocol() == QAbstractSocket::IPv6Protocol) {
+        const Q_IPV6ADDR bytes = address.toIPv6Address();
+        const UInt128 raw = UInt128::fromBytes(bytes.c);
+        return m_first <= raw && raw <= m_last;
+    }
+
+    return false;
+}
+
+/**
+ * @brief NetworkAddressRange::mid
+ * @param offset
+ * @param count
+ * @return 
+ */
+
+NetworkAddressRange NetworkAddressRange::mid(const UInt128 &offset, const UInt128 &count) const
+{
+    NetworkAddressRange range;
+
+    if (!isValid() || count.isZero() || offset > m_last - m_first) {
+        return range;
+    }
+
+    //compare against what is left instead of adding, so nothing can overflow;
+    //a count of UInt128::max() saturates like addressCount() and takes
+    //everything, even of the whole IPv6 address space
+    const UInt128 first = m_first + offset;
+    range.m_first = first;
+    range.m_last = count == UInt128::max() || count - 1 >= m_last - first ? m_last : first + count - 1;
+    range.m_family = m_family;
+
+    return range;
+}
+
+/**
+ * @brief NetworkAddressRange::split
+ * @param count
+ * @return 
+ */
+
+QVector<NetworkAddressRange> NetworkAddressRange::split(int count) const
+{
+    QVector<NetworkAddressRange> ranges;
+
+    if (!isValid() || count <= 0) {
+        return ranges;
+    }
+
+    //the first remainder ranges get one address more than the others
+    UInt128 remainder;
+    const UInt128 size = UInt128::divide(addressCount(), static_cast<quint64>(count), &remainder);
+    UInt128 offset = 0;
+
+    for (int i = 0; i < count; ++i) {
+        UInt128 length = size;
+        if (UInt128(static_cast<quint64>(i)) < remainder) {
+            ++length;
+        }
+
+        //less addresses than ranges asked for
+        if (length.isZero()) {
+            break;
+        }
+
+        //the last one takes what is left, that is only more than length if
+        //the address count saturated
+        ranges.append(i == count - 1 ? mid(offset) : mid(offset, length));
+        offset += length;
+    }
+
+    return ranges;
+}
+
+/**
+ * @brief NetworkAddressRange::toPrefixes
+ * @return 
+ */
+
+QVector<NetworkPrefix> NetworkAddressRange::toPrefixes() const
+{
+    QVector<NetworkPrefix> prefixes;
+
+    if (!isValid()) {
+        return prefixes;
+    }
+
+    const int bits = isIpv4() ? 32 : 128;
+    UInt128 current = m_first;
+
+    //every step takes the largest block that starts at current, is aligned
+    //to its own size and does not reach past last
+    for (;;) {
+        int alignment = bits;
+        if (!current.isZero()) {
+            alignment = current.lo != 0 ? static_cast<int>(qCountTrailingZeroBits(current.lo))
+                                        : 64 + static_cast<int>(qCountTrailingZeroBits(current.hi));
+            alignment = qMin(alignment, bits);
+        }
+
+        //only the whole IPv6 address space wraps around to zero
+        const UInt128 remaining = m_last - current + 1;
+        int fit = 128;
+        if (!remaining.isZero()) {
+            fit = remaining.hi != 0 ? 127 - static_cast<int>(qCountLeadingZeroBits(remaining.hi))
+                                    : 63 - static_cast<int>(qCountLeadingZeroBits(remaining.lo));
+        }
+
+        const int size = qMin(alignment, fit);
+        prefixes.append(isIpv4() ? NetworkPrefix::fromIpv4(static_cast<quint32>(current.lo), bits - size)
+                                 : NetworkPrefix::fromIpv6(current, bits - size));
+
+        const UInt128 blockLast = current + ((UInt128(1) << size) - 1);
+        if (blockLast == m_last) {
+            break;
+        }
+        current = blockLast + 1;
+    }
+
+    return prefixes;
+}
+
+/**
+ * @brief NetworkAddressRange::addressAt
+ * @param index
+ * @return 
+ */
+
+QHostAddress NetworkAddressRange::addressAt(const UInt128 &index) const
+{
+    if (index >= addressCount()) {
+        return QHostAddress();
+    }
+
+    return toHostAddress(m_first + index);
+}
+
+/**
+ * @brief NetworkAddressRange::isIpv4
+ * @return 
+ */
+
+bool NetworkAddressRange::isIpv4() const
+{
+    return m_family == Ipv4Family;
+}
+
+/**
+ * @brief NetworkAddressRange::isIpv6
+ * @return 
+ */
+
+bool NetworkAddressRange::isIpv6() const
+{
+    return m_family == Ipv6Family;
+}
+
+/**
+ * @brief NetworkAddressRange::isValid
+ * @return 
+ */
+
+bool NetworkAddressRange::isValid() const
+{
+    return m_family != NullFamily;
+}
+
+/**
+ * @brief NetworkAddressRange::addressFamily
+ * @return 
+ */
+
+QAbstractSocket::NetworkLayerProtocol NetworkAddressRange::addressFamily() const
+{
+    if (isIpv4()) {
+        return QAbstractSocket::IPv4Protocol;
+    }
+
+    if (isIpv6()) {
+        return QAbstractSocket::IPv6Protocol;
+    }
+
+    return QAbstractSocket::UnknownNetworkLayerProtocol;
+}
+
+QHostAddress NetworkAddressRange::toHostAddress(const UInt128 &address) const
+{
+    if (isIpv4()) {
+        return QHostAddress(static_cast<quint32>(address.lo));
+    }
+
+    if (isIpv6()) {
+        Q_IPV6ADDR bytes;
+        address.toBytes(bytes.c);
+        return QHostAddress(bytes);
+    }
+
+    return QHostAddress();
+}
+
+/**
+ * @brief operator <<
+ * @param dbg
+ * @param range
+ * @return 
+ */
+
+QDebug operator<<(QDebug dbg, const NetworkAddressRange &range)
+{
+    dbg.noquote();
+    dbg << range.first().toString() << "-" << range.last().toString();
+    return dbg;
+}
+
+/**
+ * @brief operator ==
+ * @param a
+ * @param b
+ * @return 
+ */
+
+bool operator==(const NetworkAddressRange &a, const NetworkAddressRange &b)
+{
+    return a.addressFamily() == b.addressFamily() && a.rawFirst() == b.rawFirst()
+           && a.rawLast() == b.rawLast();
+}
@@ -0,0 +1,73 @@
+/**
+ * A contiguous range of addresses of one family, from first() up to and
+ * including last(). Unlike a NetworkPrefix it does not have to start or end
+ * on a prefix boundary, which makes it the unit of work when a prefix or a
+ * whole NetworkPrefixSet is split into shards for several threads.
+ *
+ * Raw addresses are in host byte order, IPv4 addresses in the low 32 bits,
+ * the same as NetworkPrefix::rawAddress(). A range holds no iteration state,
+ * walk it with a NetworkAddressCursor.
+ */
+
+#ifndef NETWORKADDRESSRANGE_H
+#define NETWORKADDRESSRANGE_H
+
+#include <uint128.h>
+
+#include <QHostAddress>
+#include <QVector>
+
+class NetworkPrefix;
+
+class NetworkAddressRange
+{
+public:
+    explicit NetworkAddressRange();
+    //null if the families differ or first is after last
+    explicit NetworkAddressRange(QHostAddress first, QHostAddress last);
+
+    static NetworkAddressRange fromIpv4(quint32 first, quint32 last);
+    static NetworkAddressRange fromIpv6(const UInt128 &first, const UInt128 &last);
+
+    QHostAddress first() const;
+    QHostAddress last() const;
+    UInt128 rawFirst() const;
+    UInt128 rawLast() const;
+
+    //the whole IPv6 address space saturates at UInt128::max()
+    UInt128 addressCount() const;
+    bool containsAddress(QHostAddress address) const;
+
+    //count addresses starting at the offset-th one, like QString::mid() the
+    //default takes everything up to last()
+    NetworkAddressRange mid(const UInt128 &offset, const UInt128 &count = UInt128::max()) const;
+    //at most count contiguous ranges of (nearly) equal size covering this one
+    QVector<NetworkAddressRange> split(int count) const;
+    //the fewest prefixes covering exactly this range, in address order
+    QVector<NetworkPrefix> toPrefixes() const;
+
+    QHostAddress addressAt(const UInt128 &index) const;
+
+    bool isIpv4() const;
+    bool isIpv6() const;
+    bool isValid() const;
+
+    QAbstractSocket::NetworkLayerProtocol addressFamily() const;
+
+private:
+    enum Family : quint8 { NullFamily = 0, Ipv4Family = 4, Ipv6Family = 6 };
+
+    QHostAddress toHostAddress(const UInt128 &address) const;
+
+    UInt128 m_first;
+    UInt128 m_last;
+    Family m_family;
+};
+
+Q_DECLARE_TYPEINFO(NetworkAddressRange, Q_PRIMITIVE_TYPE);
+Q_DECLARE_METATYPE(NetworkAddressRange);
+
+QDebug operator<<(QDebug dbg, const NetworkAddressRange &range);
+bool operator==(const NetworkAddressRange &a, const NetworkAddressRange &b);
+
+#endif // NETWORKADDRESSRANGE_H
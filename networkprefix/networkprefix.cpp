@@ -1,19 +1,21 @@
 #include "networkprefix.h"
+#include "prefixmath.h"
 
-#include <QLoggingCategory>
-#include <QtMath>
+#include <QtEndian>
 
-Q_LOGGING_CATEGORY(networkprefix_log, "networkprefix");
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<NetworkPrefix>::value,
+              "NetworkPrefix has to stay a flat value type");
 
 /**
  * @brief NetworkPrefix::NetworkPrefix
  */
 
 NetworkPrefix::NetworkPrefix()
-: m_currentIteratorIndex(0)
+: m_family(NullFamily)
+, m_prefixLength(0)
 {
-    m_networkPrefix.first = QHostAddress();
-    m_networkPrefix.second = -1;
 }
 
 /**
@@ -22,19 +24,13 @@ NetworkPrefix::NetworkPrefix()
  */
 
 NetworkPrefix::NetworkPrefix(QHostAddress address)
-: m_currentIteratorIndex(0)
+: m_family(NullFamily)
+, m_prefixLength(0)
 {
-    m_networkPrefix.first = address;
-    m_networkPrefix.second = -1;
-
-    if (address.isNull()) {
-        return;
-    }
-
-    if (isIpv4()) {
-        m_networkPrefix.second = 32;
-    } else if (isIpv6()) {
-        m_networkPrefix.second = 128;
+    if (address.protocol() == QAbstractSocket::IPv4Protocol) {
+        validateBounds(address, 32);
+    } else if (address.protocol() == QAbstractSocket::IPv6Protocol) {
+        validateBounds(address, 128);
     }
 
     //if none of the above, it will leave this an invalid prefix,
@@ -48,17 +44,60 @@ NetworkPrefix::NetworkPrefix(QHostAddress address)
  */
 
 NetworkPrefix::NetworkPrefix(QHostAddress address, int prefixLength)
-: m_currentIteratorIndex(0)
+: m_family(NullFamily)
+, m_prefixLength(0)
 {
-    m_networkPrefix = validateBounds(address, prefixLength);
+    validateBounds(address, prefixLength);
 
     if (isValid()) {
         trimmPrefix();
     }
+}
+
+/**
+ * @brief NetworkPrefix::fromIpv4
+ * @param address
+ * @param prefixLength
+ * @return 
+ */
+
+NetworkPrefix NetworkPrefix::fromIpv4(quint32 address, int prefixLength)
+{
+    NetworkPrefix prefix;
+
+    if (prefixLength < 0 || prefixLength > 32) {
+        return prefix;
+    }
+
+    prefix.m_address = UInt128(address);
+    prefix.m_family = Ipv4Family;
+    prefix.m_prefixLength = static_cast<quint8>(prefixLength);
+    prefix.trimmPrefix();
+
+    return prefix;
+}
 
-    if (isIpv6() && m_networkPrefix.second <= 64) {
-        qCWarning(networkprefix_log) << "You cannot use IPv6 prefixes <= 64 for iteration";
+/**
+ * @brief NetworkPrefix::fromIpv6
+ * @param address
+ * @param prefixLength
+ * @return 
+ */
+
+NetworkPrefix NetworkPrefix::fromIpv6(const UInt128 &address, int prefixLength)
+{
+    NetworkPrefix prefix;
+
+    if (prefixLength < 0 || prefixLength > 128) {
+        return prefix;
     }
+
+    prefix.m_address = address;
+    prefix.m_family = Ipv6Family;
+    prefix.m_prefixLength = static_cast<quint8>(prefixLength);
+    prefix.trimmPrefix();
+
+    return prefix;
 }
 
 /**
@@ -68,7 +107,7 @@ NetworkPrefix::NetworkPrefix(QHostAddress address, int prefixLength)
 
 QPair<QHostAddress, int> NetworkPrefix::networkPrefix() const
 {
-    return m_networkPrefix;
+    return QPair<QHostAddress, int>(address(), prefixLength());
 }
 
 /**
@@ -104,16 +143,11 @@ void NetworkPrefix::setNetworkPrefix(const QString &prefixString)
 
 void NetworkPrefix::setNetworkPrefix(QHostAddress address, int prefixLength)
 {
-    m_networkPrefix = validateBounds(address, prefixLength);
-    m_currentIteratorIndex = 0;
+    validateBounds(address, prefixLength);
 
     if (isValid()) {
         trimmPrefix();
     }
-
-    if (isIpv6() && m_networkPrefix.second <= 64) {
-        qCWarning(networkprefix_log) << "You cannot use IPv6 prefixes <= 64 for iteration";
-    }
 }
 
 /**
@@ -123,64 +157,115 @@ void NetworkPrefix::setNetworkPrefix(QHostAddress address, int prefixLength)
 
 QHostAddress NetworkPrefix::address() const
 {
-    return m_networkPrefix.first;
+    if (m_family == Ipv4Family) {
+        return QHostAddress(static_cast<quint32>(m_address.lo));
+    }
+
+    if (m_family == Ipv6Family) {
+        Q_IPV6ADDR address;
+        m_address.toBytes(address.c);
+        return QHostAddress(address);
+    }
+
+    return QHostAddress();
 }
 
 /**
- * @brief NetworkPrefix::prefixLength
+ * @brief NetworkPrefix::rawAddress
  * @return 
  */
 
-int NetworkPrefix::prefixLength() const
+UInt128 NetworkPrefix::rawAddress() const
 {
-    return m_networkPrefix.second;
+    return m_address;
 }
 
 /**
- * @brief NetworkPrefix::resetIterator
+ * @brief NetworkPrefix::prefixLength
+ * @return 
  */
 
-void NetworkPrefix::resetIterator()
+int NetworkPrefix::prefixLength() const
 {
-    m_currentIteratorIndex = 0;
+    if (m_family == NullFamily) {
+        return -1;
+    }
+
+    return m_prefixLength;
 }
 
 /**
- * @brief NetworkPrefix::nextAddress
+ * @brief NetworkPrefix::addressAt
+ * @param index
  * @return 
  */
 
-QHostAddress NetworkPrefix::nextAddress()
+QHostAddress NetworkPrefix::addressAt(const UInt128 &index) const
 {
-    if (m_currentIteratorIndex >= addressCount()) { // last one?
+    if (index >= addressCount()) {
         return QHostAddress();
     }
 
-    // generate next address
+    if (isIpv4()) {
+        return QHostAddress(static_cast<quint32>(m_address.lo + index.lo));
+    }
+
+    Q_IPV6ADDR address;
+    (m_address + index).toBytes(address.c);
+    return QHostAddress(address);
+}
+
+/**
+ * @brief NetworkPrefix::rawAddressAt
+ * @param index
+ * @return 
+ */
+
+UInt128 NetworkPrefix::rawAddressAt(const UInt128 &index) const
+{
+    //not range checked, like operator[] on a container
+    return m_address + index;
+}
+
+/**
+ * @brief NetworkPrefix::toRange
+ * @return 
+ */
 
+NetworkAddressRange NetworkPrefix::toRange() const
+{
     if (isIpv4()) {
-        return nextIpv4Address();
+        return NetworkAddressRange::fromIpv4(static_cast<quint32>(m_address.lo),
+                                             static_cast<quint32>(m_address.lo) | ~ipv4Netmask());
     }
 
     if (isIpv6()) {
-        return nextIpv6Address();
+        return NetworkAddressRange::fromIpv6(m_address, m_address | ~ipv6Netmask());
     }
 
-    return QHostAddress();
+    return NetworkAddressRange();
 }
 
 /**
- * @brief NetworkPrefix::hasMoreAddresses
+ * @brief NetworkPrefix::split
+ * @param count
  * @return 
  */
 
-bool NetworkPrefix::hasMoreAddresses() const
+QVector<NetworkAddressRange> NetworkPrefix::split(int count) const
 {
-    if (m_currentIteratorIndex >= addressCount()) { // last one?
-        return false;
-    }
+    return toRange().split(count);
+}
 
-    return true;
+/**
+ * @brief NetworkPrefix::permutation
+ * @param seed
+ * @return 
+ */
+
+NetworkAddressPermutation NetworkPrefix::permutation(quint64 seed) const
+{
+    return NetworkAddressPermutation(toRange(), seed);
 }
 
 /**
@@ -188,19 +273,19 @@ bool NetworkPrefix::hasMoreAddresses() const
  * @return 
  */
 
-quint64 NetworkPrefix::addressCount() const
+UInt128 NetworkPrefix::addressCount() const
 {
-    //qreal as return value, because in IPv6, this could be huge
+    //128 bits as return value, because in IPv6, this could be huge
     if (!isValid()) {
         return 0;
     }
 
     if (isIpv4()) {
-        return static_cast<quint64>(qPow(2, 32 - m_networkPrefix.second));
+        return PrefixMath::ipv4AddressCount(m_prefixLength);
     }
 
     if (isIpv6()) {
-        return static_cast<quint64>(qPow(2, 128 - m_networkPrefix.second));
+        return PrefixMath::ipv6AddressCount(m_prefixLength);
     }
 
     return 0;
@@ -213,11 +298,7 @@ quint64 NetworkPrefix::addressCount() const
 
 bool NetworkPrefix::isIpv4() const
 {
-    if (addressFamily() == QAbstractSocket::IPv4Protocol) {
-        return true;
-    }
-
-    return false;
+    return m_family == Ipv4Family;
 }
 
 /**
@@ -227,11 +308,7 @@ bool NetworkPrefix::isIpv4() const
 
 bool NetworkPrefix::isIpv6() const
 {
-    if (addressFamily() == QAbstractSocket::IPv6Protocol) {
-        return true;
-    }
-
-    return false;
+    return m_family == Ipv6Family;
 }
 
 /**
@@ -240,9 +317,18 @@ bool NetworkPrefix::isIpv6() const
  * @return 
  */
 
-bool NetworkPrefix::containsAddress(QHostAddress address)
+bool NetworkPrefix::containsAddress(QHostAddress address) const
 {
-    return address.isInSubnet(m_networkPrefix);
+    if (isIpv4() && address.protocol() == QAbstractSocket::IPv4Protocol) {
+        return ((static_cast<quint32>(m_address.lo) ^ address.toIPv4Address()) & ipv4Netmask()) == 0;
+    }
+
+    if (isIpv6() && address.protocol() == QAbstractSocket::IPv6Protocol) {
+        Q_IPV6ADDR raw = address.toIPv6Address();
+        return ((m_address ^ UInt128::fromBytes(raw.c)) & ipv6Netmask()).isZero();
+    }
+
+    return false;
 }
 
 /**
@@ -251,9 +337,9 @@ bool NetworkPrefix::containsAddress(QHostAddress address)
  * @return 
  */
 
-bool NetworkPrefix::containsPrefix(NetworkPrefix prefix)
+bool NetworkPrefix::containsPrefix(NetworkPrefix prefix) const
 {
-    if (!isValid()) {
+    if (!isValid() || m_family != prefix.m_family) {
         return false;
     }
 
@@ -261,17 +347,13 @@ bool NetworkPrefix::containsPrefix(NetworkPrefix prefix)
         return false;
     }
 
-    if (prefix == *this) {
-        return true;
-    }
-
     //now we have to take a close look
     //pretend the longer prefix is an address and see if it is inside the larger
-    if (containsAddress(prefix.address())) {
-        return true;
+    if (isIpv4()) {
+        return ((m_address.lo ^ prefix.m_address.lo) & ipv4Netmask()) == 0;
     }
 
-    return false;
+    return ((m_address ^ prefix.m_address) & ipv6Netmask()).isZero();
 }
 
 /**
@@ -280,7 +362,7 @@ bool NetworkPrefix::containsPrefix(NetworkPrefix prefix)
  * @return 
  */
 
-bool NetworkPrefix::canAggregate(NetworkPrefix prefix)
+bool NetworkPrefix::canAggregate(NetworkPrefix prefix) const
 {
     if (aggregate(*this, prefix) == NetworkPrefix()) {
         return false;
@@ -326,52 +408,18 @@ NetworkPrefix NetworkPrefix::aggregate(NetworkPrefix a, NetworkPrefix b)
         return NetworkPrefix();
     }
 
-    //check whether they only differ in the last bit
-    if (a.isIpv4()) {
-        quint32 aAsInt = a.address().toIPv4Address();
-        quint32 bAsInt = b.address().toIPv4Address();
-
-        if (((aAsInt ^ bAsInt) >> (32 - a.prefixLength())) == 1) {
-            return NetworkPrefix(a.address(), a.prefixLength() - 1);
-        }
+    //check whether they only differ in the last bit, which is worth exactly
+    //as much as the number of addresses in the prefix
+    if (a.prefixLength() == 0) {
+        return NetworkPrefix();
     }
 
-    if (a.isIpv6()) {
-        Q_IPV6ADDR aAsArray = a.address().toIPv6Address();
-        Q_IPV6ADDR bAsArray = b.address().toIPv6Address();
-
-        int arrCount = a.prefixLength() / 8;
-        int restBits = a.prefixLength() % 8;
-
-        for (int i = 0; i < arrCount - 1; ++i) {
-            //qDebug() << "Checking: " << QString::number(aAsArray[i], 16) << " and "
-            //         << QString::number(aAsArray[i], 16);
-
-            if (aAsArray[i] ^ bAsArray[i]) {
-                return NetworkPrefix();
-            }
-        }
-
-        //need to check the last arr for 0 and the check the rest bits separately
-        if (restBits) {
-            if (aAsArray[arrCount - 1] ^ bAsArray[arrCount - 1]) {
-                return NetworkPrefix();
-            }
-
-            //check the remaining bits
-            if ((aAsArray[arrCount] ^ bAsArray[arrCount]) >> (8 - restBits) == 1) {
-                return NetworkPrefix(a.address(), a.prefixLength() - 1);
-            } else {
-                return NetworkPrefix();
-            }
+    if (a.isIpv4() && (a.m_address ^ b.m_address) == PrefixMath::ipv4AddressCount(a.prefixLength())) {
+        return fromIpv4(static_cast<quint32>(a.m_address.lo), a.prefixLength() - 1);
+    }
 
-        } else {
-            if ((aAsArray[arrCount - 1] ^ bAsArray[arrCount - 1]) != 1) {
-                return NetworkPrefix();
-            } else {
-                return NetworkPrefix(a.address(), a.prefixLength() - 1);
-            }
-        }
+    if (a.isIpv6() && (a.m_address ^ b.m_address) == PrefixMath::ipv6AddressCount(a.prefixLength())) {
+        return fromIpv6(a.m_address, a.prefixLength() - 1);
     }
 
     return NetworkPrefix();
@@ -384,9 +432,12 @@ NetworkPrefix NetworkPrefix::aggregate(NetworkPrefix a, NetworkPrefix b)
 
 QAbstractSocket::NetworkLayerProtocol NetworkPrefix::addressFamily() const
 {
-    if (m_networkPrefix.first.protocol() == QAbstractSocket::IPv4Protocol
-        || m_networkPrefix.first.protocol() == QAbstractSocket::IPv6Protocol) {
-        return m_networkPrefix.first.protocol();
+    if (m_family == Ipv4Family) {
+        return QAbstractSocket::IPv4Protocol;
+    }
+
+    if (m_family == Ipv6Family) {
+        return QAbstractSocket::IPv6Protocol;
     }
 
     return QAbstractSocket::UnknownNetworkLayerProtocol;
@@ -399,13 +450,8 @@ QAbstractSocket::NetworkLayerProtocol NetworkPrefix::addressFamily() const
 
 bool NetworkPrefix::isValid() const
 {
-    //since it should be impossible to set an crazy prefix combination
-    //just checking the address pr prefix should be enough, but...
-    if (m_networkPrefix.first.isNull() || m_networkPrefix.second < 0) {
-        return false;
-    }
-
-    return true;
+    //validateBounds() only ever sets a family for a sane prefix length
+    return m_family != NullFamily;
 }
 
 /**
@@ -420,7 +466,7 @@ quint32 NetworkPrefix::ipv4Netmask() const
         return 0;
     }
 
-    return static_cast<quint32>(~(qFloor(qPow(2, 32 - m_networkPrefix.second) - 1)));
+    return PrefixMath::ipv4Netmask(m_prefixLength);
 }
 
 /**
@@ -428,29 +474,13 @@ quint32 NetworkPrefix::ipv4Netmask() const
  * @return 
  */
 
-Q_IPV6ADDR NetworkPrefix::ipv6Netmask() const
+UInt128 NetworkPrefix::ipv6Netmask() const
 {
-    Q_IPV6ADDR mask;
-    for (int i = 0; i < 16; ++i) {
-        mask[i] = 0;
-    }
-
     if (!isIpv6()) {
-        return mask;
-    }
-
-    //first see how many of the 16 array elements we need to look at
-    int arrCount = m_networkPrefix.second / 8;
-    int restBits = m_networkPrefix.second % 8;
-    for (int i = 0; i < arrCount; ++i) {
-        mask[i] = 255;
-    }
-
-    if (restBits) {
-        mask[arrCount] = static_cast<quint8>(~(qFloor(qPow(2, 8 - restBits) - 1)));
+        return UInt128();
     }
 
-    return mask;
+    return PrefixMath::ipv6Netmask(m_prefixLength);
 }
 
 /**
@@ -460,30 +490,30 @@ Q_IPV6ADDR NetworkPrefix::ipv6Netmask() const
  * @return 
  */
 
-QPair<QHostAddress, int> NetworkPrefix::validateBounds(QHostAddress addr, int prefixLength) const
+void NetworkPrefix::validateBounds(QHostAddress addr, int prefixLength)
 {
-    if (addr.isNull()) {
-        return QPair<QHostAddress, int>(addr, -1);
-    }
+    //anything that does not pass ends up as null prefix
+    m_address = UInt128();
+    m_family = NullFamily;
+    m_prefixLength = 0;
 
-    if (prefixLength < 0) {
-        return QPair<QHostAddress, int>(QHostAddress(), -1);
-    }
-
-    if (addr.protocol() == QAbstractSocket::IPv4Protocol && prefixLength > 32) {
-        return QPair<QHostAddress, int>(QHostAddress(), -1);
+    if (addr.isNull() || prefixLength < 0) {
+        return;
     }
 
-    if (addr.protocol() == QAbstractSocket::IPv6Protocol && prefixLength > 128) {
-        return QPair<QHostAddress, int>(QHostAddress(), -1);
+    if (addr.protocol() == QAbstractSocket::IPv4Protocol && prefixLength <= 32) {
+        m_address = UInt128(addr.toIPv4Address());
+        m_family = Ipv4Family;
+        m_prefixLength = static_cast<quint8>(prefixLength);
+        return;
     }
 
-    if (addr.protocol() != QAbstractSocket::IPv6Protocol
-        && addr.protocol() != QAbstractSocket::IPv4Protocol) {
-        return QPair<QHostAddress, int>(QHostAddress(), -1);
+    if (addr.protocol() == QAbstractSocket::IPv6Protocol && prefixLength <= 128) {
+        Q_IPV6ADDR address = addr.toIPv6Address();
+        m_address = UInt128::fromBytes(address.c);
+        m_family = Ipv6Family;
+        m_prefixLength = static_cast<quint8>(prefixLength);
     }
-
-    return QPair<QHostAddress, int>(addr, prefixLength);
 }
 
 /**
@@ -508,14 +538,7 @@ void NetworkPrefix::trimmPrefix()
 
 void NetworkPrefix::trimmIpv4()
 {
-    quint32 mask = ipv4Netmask();
-    quint32 addr = m_networkPrefix.first.toIPv4Address();
-    quint32 originalAddress = addr;
-
-    addr = addr & mask;
-    if (addr != originalAddress) {
-        m_networkPrefix.first = QHostAddress(addr);
-    }
+    m_address.lo &= PrefixMath::ipv4Netmask(m_prefixLength);
 }
 
 /**
@@ -524,54 +547,113 @@ void NetworkPrefix::trimmIpv4()
 
 void NetworkPrefix::trimmIpv6()
 {
-    Q_IPV6ADDR mask = ipv6Netmask();
-    Q_IPV6ADDR addr = m_networkPrefix.first.toIPv6Address();
-    Q_IPV6ADDR originalAddress = addr;
+    m_address &= PrefixMath::ipv6Netmask(m_prefixLength);
+}
+
+/**
+ * @brief NetworkPrefix::encode
+ * @param data
+ * @return 
+ */
+
+int NetworkPrefix::encode(uchar *data) const
+{
+    data[0] = m_family;
+    data[1] = m_prefixLength;
 
-    for (int i = 0; i < 16; ++i) {
-        addr[i] = addr[i] & mask[i];
+    if (isIpv4()) {
+        qToBigEndian<quint32>(static_cast<quint32>(m_address.lo), data + 2);
+        return 6;
     }
 
-    //compare and set inc case they differ
-    for (int i = 0; i < 16; ++i) {
-        if (addr[i] != originalAddress[i]) {
-            m_networkPrefix.first = QHostAddress(addr);
-            break;
-        }
+    if (isIpv6()) {
+        m_address.toBytes(data + 2);
+        return 18;
     }
+
+    return 2;
 }
 
 /**
- * @brief NetworkPrefix::nextIpv4Address
+ * @brief NetworkPrefix::decode
+ * @param data
+ * @param size
+ * @param used
  * @return 
  */
 
-QHostAddress NetworkPrefix::nextIpv4Address()
+NetworkPrefix NetworkPrefix::decode(const uchar *data, int size, int *used)
 {
-    //make sure isValid() has been called before calling nextIpv4Address
-    quint32 addr = m_networkPrefix.first.toIPv4Address();
-    addr += m_currentIteratorIndex;
-    ++m_currentIteratorIndex;
-    return QHostAddress(addr);
+    NetworkPrefix prefix;
+    *used = 0;
+
+    if (size < 2) {
+        return prefix;
+    }
+
+    if (data[0] == NullFamily && data[1] == 0) {
+        *used = 2;
+    } else if (data[0] == Ipv4Family && data[1] <= 32 && size >= 6) {
+        prefix = fromIpv4(qFromBigEndian<quint32>(data + 2), data[1]);
+        *used = 6;
+    } else if (data[0] == Ipv6Family && data[1] <= 128 && size >= 18) {
+        prefix = fromIpv6(UInt128::fromBytes(data + 2), data[1]);
+        *used = 18;
+    }
+
+    return prefix;
 }
 
 /**
- * @brief NetworkPrefix::nextIpv6Address
+ * @brief operator <<
+ * @param stream
+ * @param prefix
  * @return 
  */
 
-QHostAddress NetworkPrefix::nextIpv6Address()
+QDataStream &operator<<(QDataStream &stream, const NetworkPrefix &prefix)
 {
-    Q_IPV6ADDR address = m_networkPrefix.first.toIPv6Address();
+    uchar data[NetworkPrefix::MaxEncodedSize];
+    const int size = prefix.encode(data);
 
-    //make the bottom part reflect the counter
-    for (int i = 15; i > 7; --i) {
-        address[i] += (m_currentIteratorIndex >> (8 * (15 - i)));
+    if (stream.writeRawData(reinterpret_cast<const char *>(data), size) != size) {
+        stream.setStatus(QDataStream::WriteFailed);
     }
 
-    ++m_currentIteratorIndex;
+    return stream;
+}
 
-    return QHostAddress(address);
+/**
+ * @brief operator >>
+ * @param stream
+ * @param prefix
+ * @return 
+ */
+
+QDataStream &operator>>(QDataStream &stream, NetworkPrefix &prefix)
+{
+    uchar data[NetworkPrefix::MaxEncodedSize];
+    int used;
+    prefix = NetworkPrefix();
+
+    //the family decides how many address bytes follow
+    if (stream.readRawData(reinterpret_cast<char *>(data), 1) != 1) {
+        stream.setStatus(QDataStream::ReadPastEnd);
+        return stream;
+    }
+
+    const int size = data[0] == 4 ? 6 : data[0] == 6 ? 18 : 2;
+    if (stream.readRawData(reinterpret_cast<char *>(data) + 1, size - 1) != size - 1) {
+        stream.setStatus(QDataStream::ReadPastEnd);
+        return stream;
+    }
+
+    prefix = NetworkPrefix::decode(data, size, &used);
+    if (used == 0) {
+        stream.setStatus(QDataStream::ReadCorruptData);
+    }
+
+    return stream;
 }
 
 /**
@@ -597,5 +679,28 @@ QDebug operator<<(QDebug dbg, const NetworkPrefix &prefix)
 
 bool operator==(NetworkPrefix a, NetworkPrefix b)
 {
-    return a.address() == b.address() && a.prefixLength() == b.prefixLength();
+    return a.addressFamily() == b.addressFamily() && a.prefixLength() == b.prefixLength()
+           && a.rawAddress() == b.rawAddress();
+}
+
+/**
+ * @brief qHash
+ * @param prefix
+ * @param seed
+ * @return 
+ */
+
+uint qHash(const NetworkPrefix &prefix, uint seed) noexcept
+{
+    //everything operator== compares goes through the SplitMix64 finalizer,
+    //so prefixes that only differ in a few bits still spread over the buckets
+    const UInt128 address = prefix.rawAddress();
+    const quint64 tags = static_cast<quint64>(prefix.addressFamily()) << 8
+                         | static_cast<quint8>(prefix.prefixLength());
+
+    quint64 hash = PrefixMath::mix(seed ^ address.hi);
+    hash = PrefixMath::mix(hash ^ address.lo);
+    hash = PrefixMath::mix(hash ^ tags);
+
+    return static_cast<uint>(hash ^ (hash >> 32));
 }
@@ -1,18 +1,34 @@
 /**
- * Current limitation: IPv6 prefixes can only be iterated up to a /64
- * anything smaller, e.g. a /60 cannot be iterated as the internal counter
- * is a 64-bit integer. But honestly, when you have to go through 2^64 addresses
- * there seems to be something wrong. 
+ * Address counts and cursor positions are 128-bit integers, so counting and
+ * iterating works for prefixes of any length. The only exception is ::/0,
+ * which has one address more than 128 bits can hold; its count is reported as
+ * UInt128::max(). But honestly, when you have to go through 2^128 addresses
+ * there seems to be something wrong.
+ *
+ * A prefix carries no iteration state, all queries are const and one prefix
+ * can be read from any number of threads; each of them walks it with its own
+ * const_iterator or NetworkAddressCursor.
  */
 
 #ifndef NETWORKPREFIX_H
 #define NETWORKPREFIX_H
 
+#include <networkaddresscursor.h>
+#include <networkaddresspermutation.h>
+#include <networkaddressrange.h>
+#include <uint128.h>
+
+#include <QDataStream>
 #include <QHostAddress>
 
+#include <functional>
+#include <iterator>
+
 class NetworkPrefix
 {
 public:
+    class const_iterator;
+
     explicit NetworkPrefix();
     explicit NetworkPrefix(QHostAddress address);
 
@@ -28,25 +44,42 @@ public:
     {}
     explicit NetworkPrefix(QHostAddress address, int prefixLength);
 
+    //construct from raw addresses in host byte order, without going through QHostAddress
+    static NetworkPrefix fromIpv4(quint32 address, int prefixLength);
+    static NetworkPrefix fromIpv6(const UInt128 &address, int prefixLength);
+
     QPair<QHostAddress, int> networkPrefix() const;
     void setNetworkPrefix(const QPair<QHostAddress, int> &networkPrefix);
     void setNetworkPrefix(const QString &prefixString);
     void setNetworkPrefix(QHostAddress address, int prefixLength);
 
     QHostAddress address() const;
+    UInt128 rawAddress() const; //IPv4 addresses are in the low 32 bits
     int prefixLength() const;
 
-    void resetIterator();
-    QHostAddress nextAddress();
-    bool hasMoreAddresses() const;
-    quint64 addressCount() const;
+    UInt128 addressCount() const;
+
+    //a null address if the index is out of range; to walk the addresses use
+    //begin()/end() or a NetworkAddressCursor
+    QHostAddress addressAt(const UInt128 &index) const;
+    UInt128 rawAddressAt(const UInt128 &index) const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    NetworkAddressRange toRange() const;
+    //contiguous shards of (nearly) equal size, e.g. one per worker thread;
+    //fewer than count if the prefix has less addresses
+    QVector<NetworkAddressRange> split(int count) const;
+    //all addresses in a seeded pseudo-random order
+    NetworkAddressPermutation permutation(quint64 seed) const;
 
     bool isIpv4() const;
     bool isIpv6() const;
 
-    bool containsAddress(QHostAddress address);
-    bool containsPrefix(NetworkPrefix prefix);
-    bool canAggregate(NetworkPrefix prefix);
+    bool containsAddress(QHostAddress address) const;
+    bool containsPrefix(NetworkPrefix prefix) const;
+    bool canAggregate(NetworkPrefix prefix) const;
 
     static NetworkPrefix aggregate(NetworkPrefix a, NetworkPrefix b);
 
@@ -54,26 +87,146 @@ public:
 
     bool isValid() const;
 
+    //the binary encoding used by the QDataStream operators: family (0, 4 or
+    //6), prefix length and 0, 4 or 16 address bytes in network byte order
+    static const int MaxEncodedSize = 18;
+    int encode(uchar *data) const;
+    //a null prefix and *used set to 0 if the data is too short or corrupt
+    static NetworkPrefix decode(const uchar *data, int size, int *used);
+
 private:
-    QHostAddress nextIpv4Address();
-    QHostAddress nextIpv6Address();
+    enum Family : quint8 { NullFamily = 0, Ipv4Family = 4, Ipv6Family = 6 };
 
     quint32 ipv4Netmask() const;    //should we make this public?
-    Q_IPV6ADDR ipv6Netmask() const; //should we make this public?
+    UInt128 ipv6Netmask() const;    //should we make this public?
 
-    QPair<QHostAddress, int> validateBounds(QHostAddress addr, int prefixLength) const;
+    void validateBounds(QHostAddress addr, int prefixLength);
 
     void trimmPrefix();
     void trimmIpv4();
     void trimmIpv6();
 
-    QPair<QHostAddress, int> m_networkPrefix;
-    quint64 m_currentIteratorIndex;
+    //everything is stored inline, a null prefix is all zeros
+    UInt128 m_address;
+    Family m_family;
+    quint8 m_prefixLength;
+};
+
+/**
+ * Iterator over the addresses of a prefix. It only keeps a pointer to the
+ * prefix and an index, so any number of them can walk the same prefix at
+ * once, and it + k is the k-th address without stepping through the ones in
+ * between. Dereferencing creates the QHostAddress on the fly, use rawAddress()
+ * to skip that.
+ *
+ * It declares itself a random access iterator, so std::distance(),
+ * std::advance() and std::lower_bound() jump instead of walking, but
+ * reference is a proxy: operator*() returns the address by value, there is
+ * no address in memory to point to.
+ *
+ * The difference of two iterators is a qint64, it only makes sense for
+ * prefixes with less than 2^63 addresses. The prefix has to outlive the
+ * iterator.
+ */
+class NetworkPrefix::const_iterator
+{
+public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef qint64 difference_type;
+    typedef QHostAddress value_type;
+    typedef const QHostAddress *pointer;
+    typedef QHostAddress reference;
+
+    const_iterator()
+    : m_prefix(nullptr)
+    {}
+    const_iterator(const NetworkPrefix *prefix, const UInt128 &index)
+    : m_prefix(prefix)
+    , m_index(index)
+    {}
+
+    QHostAddress operator*() const { return m_prefix->addressAt(m_index); }
+    QHostAddress operator[](difference_type n) const { return *(*this + n); }
+    UInt128 rawAddress() const { return m_prefix->rawAddressAt(m_index); }
+    UInt128 index() const { return m_index; }
+
+    const_iterator &operator++()
+    {
+        ++m_index;
+        return *this;
+    }
+    const_iterator operator++(int)
+    {
+        const_iterator it = *this;
+        ++m_index;
+        return it;
+    }
+    const_iterator &operator--()
+    {
+        --m_index;
+        return *this;
+    }
+    const_iterator operator--(int)
+    {
+        const_iterator it = *this;
+        --m_index;
+        return it;
+    }
+
+    const_iterator &operator+=(difference_type n)
+    {
+        //the index wraps like any unsigned integer, so adding the two's
+        //complement of a negative n moves backwards
+        m_index += UInt128(n < 0 ? ~quint64(0) : 0, static_cast<quint64>(n));
+        return *this;
+    }
+    const_iterator &operator-=(difference_type n) { return *this += -n; }
+    const_iterator operator+(difference_type n) const { return const_iterator(*this) += n; }
+    const_iterator operator-(difference_type n) const { return const_iterator(*this) -= n; }
+    friend const_iterator operator+(difference_type n, const const_iterator &it) { return it + n; }
+
+    difference_type operator-(const const_iterator &other) const
+    {
+        return static_cast<difference_type>((m_index - other.m_index).lo);
+    }
+
+    bool operator==(const const_iterator &other) const { return m_index == other.m_index; }
+    bool operator!=(const const_iterator &other) const { return m_index != other.m_index; }
+    bool operator<(const const_iterator &other) const { return m_index < other.m_index; }
+    bool operator>(const const_iterator &other) const { return m_index > other.m_index; }
+    bool operator<=(const const_iterator &other) const { return m_index <= other.m_index; }
+    bool operator>=(const const_iterator &other) const { return m_index >= other.m_index; }
+
+private:
+    const NetworkPrefix *m_prefix;
+    UInt128 m_index;
 };
 
+inline NetworkPrefix::const_iterator NetworkPrefix::begin() const
+{
+    return const_iterator(this, 0);
+}
+
+inline NetworkPrefix::const_iterator NetworkPrefix::end() const
+{
+    return const_iterator(this, addressCount());
+}
+
+Q_DECLARE_TYPEINFO(NetworkPrefix, Q_PRIMITIVE_TYPE);
 Q_DECLARE_METATYPE(NetworkPrefix);
 
 QDebug operator<<(QDebug dbg, const NetworkPrefix &prefix);
 bool operator==(NetworkPrefix a, NetworkPrefix b);
+uint qHash(const NetworkPrefix &prefix, uint seed = 0) noexcept;
+QDataStream &operator<<(QDataStream &stream, const NetworkPrefix &prefix);
+QDataStream &operator>>(QDataStream &stream, NetworkPrefix &prefix);
+
+namespace std {
+template<>
+struct hash<NetworkPrefix>
+{
+    size_t operator()(const NetworkPrefix &prefix) const noexcept { return qHash(prefix); }
+};
+} // namespace std
 
 #endif // NETWORKPREFIX_H
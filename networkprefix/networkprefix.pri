@@ -3,9 +3,17 @@ QT *= network
 INCLUDEPATH += $$PWD
 
 SOURCES += \
+    $$PWD/networkaddresscursor.cpp \
+    $$PWD/networkaddresspermutation.cpp \
+    $$PWD/networkaddressrange.cpp \
     $$PWD/networkprefix.cpp
 
 HEADERS += \
-    $$PWD/networkprefix.h
+    $$PWD/networkaddresscursor.h \
+    $$PWD/networkaddresspermutation.h \
+    $$PWD/networkaddressrange.h \
+    $$PWD/networkprefix.h \
+    $$PWD/prefixmath.h \
+    $$PWD/uint128.h
 
 
@@ -0,0 +1,99 @@
+/**
+ * Netmasks, host masks and address counts for every prefix length, as
+ * constexpr lookup tables. Everything here can be used at compile time, and at
+ * runtime a mask is a single load instead of a floating point power of two.
+ * All lengths from 0 up to and including 32 resp. 128 are valid, nothing in
+ * here shifts by the full width of a type.
+ *
+ * IPv4 masks are in the low 32 bits, like NetworkPrefix::rawAddress(). IPv6
+ * masks cover the whole 128 bits.
+ *
+ * mix() is the bit mixer shared by the prefix hash and the address
+ * permutation.
+ */
+
+#ifndef PREFIXMATH_H
+#define PREFIXMATH_H
+
+#include <uint128.h>
+
+#include <array>
+#include <utility>
+
+namespace PrefixMath {
+
+namespace detail {
+
+constexpr quint32 computeIpv4Netmask(int length)
+{
+    return length == 0 ? 0 : ~quint32(0) << (32 - length);
+}
+
+constexpr UInt128 computeIpv6Netmask(int length)
+{
+    return ~UInt128() << (128 - length);
+}
+
+template<std::size_t... Lengths>
+constexpr std::array<quint32, sizeof...(Lengths)> ipv4NetmaskTable(std::index_sequence<Lengths...>)
+{
+    return {{computeIpv4Netmask(static_cast<int>(Lengths))...}};
+}
+
+template<std::size_t... Lengths>
+constexpr std::array<UInt128, sizeof...(Lengths)> ipv6NetmaskTable(std::index_sequence<Lengths...>)
+{
+    return {{computeIpv6Netmask(static_cast<int>(Lengths))...}};
+}
+
+constexpr std::array<quint32, 33> ipv4Netmasks = ipv4NetmaskTable(std::make_index_sequence<33>());
+constexpr std::array<UInt128, 129> ipv6Netmasks = ipv6NetmaskTable(std::make_index_sequence<129>());
+
+} // namespace detail
+
+constexpr quint32 ipv4Netmask(int prefixLength)
+{
+    return detail::ipv4Netmasks[prefixLength];
+}
+
+constexpr quint32 ipv4Hostmask(int prefixLength)
+{
+    return ~detail::ipv4Netmasks[prefixLength];
+}
+
+constexpr UInt128 ipv6Netmask(int prefixLength)
+{
+    return detail::ipv6Netmasks[prefixLength];
+}
+
+constexpr UInt128 ipv6Hostmask(int prefixLength)
+{
+    return ~detail::ipv6Netmasks[prefixLength];
+}
+
+//2^(32 - prefixLength) always fits, even for a /0
+constexpr quint64 ipv4AddressCount(int prefixLength)
+{
+    return static_cast<quint64>(ipv4Hostmask(prefixLength)) + 1;
+}
+
+//2^(128 - prefixLength); a /0 has one address more than UInt128 can hold and
+//is reported as UInt128::max()
+constexpr UInt128 ipv6AddressCount(int prefixLength)
+{
+    return prefixLength == 0 ? UInt128::max() : ipv6Hostmask(prefixLength) + 1;
+}
+
+//the SplitMix64 finalizer, a cheap 64-bit mixer with good avalanche
+constexpr quint64 mix(quint64 value)
+{
+    value ^= value >> 30;
+    value *= Q_UINT64_C(0xbf58476d1ce4e5b9);
+    value ^= value >> 27;
+    value *= Q_UINT64_C(0x94d049bb133111eb);
+    return value ^ (value >> 31);
+}
+
+} // namespace PrefixMath
+
+#endif // PREFIXMATH_H
@@ -0,0 +1,310 @@
+/**
+ * A small, portable unsigned 128-bit integer. It is used wherever a full IPv6
+ * address (or a count of IPv6 addresses) has to be handled as a single number.
+ * Not every compiler we care about offers unsigned __int128, so this is a plain
+ * struct of two 64-bit halves with the usual operators. Overflow wraps, like it
+ * does for the built-in unsigned types.
+ */
+
+#ifndef UINT128_H
+#define UINT128_H
+
+#include <QDebug>
+#include <QString>
+#include <QtAlgorithms>
+#include <QtGlobal>
+
+struct UInt128
+{
+    quint64 hi;
+    quint64 lo;
+
+    constexpr UInt128()
+    : hi(0)
+    , lo(0)
+    {}
+
+    constexpr UInt128(quint64 low)
+    : hi(0)
+    , lo(low)
+    {}
+
+    constexpr UInt128(quint64 high, quint64 low)
+    : hi(high)
+    , lo(low)
+    {}
+
+    static constexpr UInt128 max() { return UInt128(~quint64(0), ~quint64(0)); }
+
+    //bit 0 is the most significant bit, bit 127 the least significant one
+    constexpr bool bit(int index) const
+    {
+        return index < 64 ? ((hi >> (63 - index)) & 1) : ((lo >> (127 - index)) & 1);
+    }
+
+    constexpr bool isZero() const { return hi == 0 && lo == 0; }
+
+    int countLeadingZeroBits() const
+    {
+        return hi ? static_cast<int>(qCountLeadingZeroBits(hi))
+                  : 64 + static_cast<int>(qCountLeadingZeroBits(lo));
+    }
+
+    static UInt128 fromBytes(const quint8 *bytes)
+    {
+        quint64 high = 0;
+        quint64 low = 0;
+        for (int i = 0; i < 8; ++i) {
+            high = (high << 8) | bytes[i];
+            low = (low << 8) | bytes[i + 8];
+        }
+        return UInt128(high, low);
+    }
+
+    void toBytes(quint8 *bytes) const
+    {
+        for (int i = 0; i < 8; ++i) {
+            bytes[i] = static_cast<quint8>(hi >> (56 - 8 * i));
+            bytes[i + 8] = static_cast<quint8>(lo >> (56 - 8 * i));
+        }
+    }
+
+    UInt128 &operator++()
+    {
+        ++lo;
+        if (lo == 0) {
+            ++hi;
+        }
+        return *this;
+    }
+
+    UInt128 &operator--()
+    {
+        if (lo == 0) {
+            --hi;
+        }
+        --lo;
+        return *this;
+    }
+
+    static UInt128 divide(const UInt128 &dividend, const UInt128 &divisor, UInt128 *remainder = nullptr);
+
+    QString toString() const;
+
+    UInt128 &operator+=(const UInt128 &other);
+    UInt128 &operator-=(const UInt128 &other);
+    UInt128 &operator*=(const UInt128 &other);
+    UInt128 &operator/=(const UInt128 &other);
+    UInt128 &operator&=(const UInt128 &other);
+    UInt128 &operator|=(const UInt128 &other);
+    UInt128 &operator<<=(int shift);
+    UInt128 &operator>>=(int shift);
+};
+
+Q_DECLARE_TYPEINFO(UInt128, Q_PRIMITIVE_TYPE);
+
+constexpr bool operator==(const UInt128 &a, const UInt128 &b)
+{
+    return a.hi == b.hi && a.lo == b.lo;
+}
+
+constexpr bool operator!=(const UInt128 &a, const UInt128 &b)
+{
+    return !(a == b);
+}
+
+constexpr bool operator<(const UInt128 &a, const UInt128 &b)
+{
+    return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo);
+}
+
+constexpr bool operator>(const UInt128 &a, const UInt128 &b)
+{
+    return b < a;
+}
+
+constexpr bool operator<=(const UInt128 &a, const UInt128 &b)
+{
+    return !(b < a);
+}
+
+constexpr bool operator>=(const UInt128 &a, const UInt128 &b)
+{
+    return !(a < b);
+}
+
+constexpr UInt128 operator~(const UInt128 &a)
+{
+    return UInt128(~a.hi, ~a.lo);
+}
+
+constexpr UInt128 operator&(const UInt128 &a, const UInt128 &b)
+{
+    return UInt128(a.hi & b.hi, a.lo & b.lo);
+}
+
+constexpr UInt128 operator|(const UInt128 &a, const UInt128 &b)
+{
+    return UInt128(a.hi | b.hi, a.lo | b.lo);
+}
+
+constexpr UInt128 operator^(const UInt128 &a, const UInt128 &b)
+{
+    return UInt128(a.hi ^ b.hi, a.lo ^ b.lo);
+}
+
+//shifting by 128 or more yields 0, instead of being undefined like for built-in types
+constexpr UInt128 operator<<(const UInt128 &a, int shift)
+{
+    return shift <= 0 ? a
+                      : shift >= 128 ? UInt128()
+                                     : shift >= 64 ? UInt128(a.lo << (shift - 64), 0)
+                                                   : UInt128((a.hi << shift) | (a.lo >> (64 - shift)),
+                                                             a.lo << shift);
+}
+
+constexpr UInt128 operator>>(const UInt128 &a, int shift)
+{
+    return shift <= 0 ? a
+                      : shift >= 128 ? UInt128()
+                                     : shift >= 64 ? UInt128(0, a.hi >> (shift - 64))
+                                                   : UInt128(a.hi >> shift,
+                                                             (a.lo >> shift) | (a.hi << (64 - shift)));
+}
+
+constexpr UInt128 operator+(const UInt128 &a, const UInt128 &b)
+{
+    return UInt128(a.hi + b.hi + ((a.lo + b.lo) < a.lo ? 1 : 0), a.lo + b.lo);
+}
+
+constexpr UInt128 operator-(const UInt128 &a, const UInt128 &b)
+{
+    return UInt128(a.hi - b.hi - (a.lo < b.lo ? 1 : 0), a.lo - b.lo);
+}
+
+//only the low 128 bits of the product are kept
+inline UInt128 operator*(const UInt128 &a, const UInt128 &b)
+{
+    //64 x 64 bit multiplication of the low halves, done in 32-bit pieces
+    const quint64 a0 = a.lo & 0xffffffff;
+    const quint64 a1 = a.lo >> 32;
+    const quint64 b0 = b.lo & 0xffffffff;
+    const quint64 b1 = b.lo >> 32;
+
+    const quint64 p00 = a0 * b0;
+    const quint64 p01 = a0 * b1;
+    const quint64 p10 = a1 * b0;
+    const quint64 p11 = a1 * b1;
+
+    const quint64 middle = (p00 >> 32) + (p01 & 0xffffffff) + (p10 & 0xffffffff);
+    const quint64 low = (middle << 32) | (p00 & 0xffffffff);
+    const quint64 high = p11 + (p01 >> 32) + (p10 >> 32) + (middle >> 32) + a.hi * b.lo
+                         + a.lo * b.hi;
+
+    return UInt128(high, low);
+}
+
+//division by zero yields zero
+inline UInt128 UInt128::divide(const UInt128 &dividend, const UInt128 &divisor, UInt128 *remainder)
+{
+    UInt128 quotient;
+    UInt128 rest;
+
+    if (divisor.isZero()) {
+        if (remainder) {
+            *remainder = UInt128();
+        }
+        return quotient;
+    }
+
+    //plain shift and subtract, starting at the highest bit set in the dividend
+    for (int i = dividend.countLeadingZeroBits(); i < 128; ++i) {
+        rest = (rest << 1) | UInt128(dividend.bit(i) ? 1 : 0);
+        quotient <<= 1;
+        if (rest >= divisor) {
+            rest -= divisor;
+            quotient.lo |= 1;
+        }
+    }
+
+    if (remainder) {
+        *remainder = rest;
+    }
+
+    return quotient;
+}
+
+inline UInt128 operator/(const UInt128 &a, const UInt128 &b)
+{
+    return UInt128::divide(a, b);
+}
+
+inline UInt128 operator%(const UInt128 &a, const UInt128 &b)
+{
+    UInt128 remainder;
+    UInt128::divide(a, b, &remainder);
+    return remainder;
+}
+
+inline QString UInt128::toString() const
+{
+    //print in chunks of 19 decimal digits, the most that fit into a quint64
+    const quint64 chunk = Q_UINT64_C(10000000000000000000);
+    UInt128 rest;
+    UInt128 high = divide(*this, chunk, &rest);
+    QString low = QString::number(rest.lo);
+
+    if (high.isZero()) {
+        return low;
+    }
+
+    return high.toString() + low.rightJustified(19, QLatin1Char('0'));
+}
+
+inline QDebug operator<<(QDebug dbg, const UInt128 &value)
+{
+    dbg << value.toString();
+    return dbg;
+}
+
+inline UInt128 &UInt128::operator+=(const UInt128 &other)
+{
+    return *this = *this + other;
+}
+
+inline UInt128 &UInt128::operator-=(const UInt128 &other)
+{
+    return *this = *this - other;
+}
+
+inline UInt128 &UInt128::operator*=(const UInt128 &other)
+{
+    return *this = *this * other;
+}
+
+inline UInt128 &UInt128::operator/=(const UInt128 &other)
+{
+    return *this = *this / other;
+}
+
+inline UInt128 &UInt128::operator&=(const UInt128 &other)
+{
+    return *this = *this & other;
+}
+
+inline UInt128 &UInt128::operator|=(const UInt128 &other)
+{
+    return *this = *this | other;
+}
+
+inline UInt128 &UInt128::operator<<=(int shift)
+{
+    return *this = *this << shift;
+}
+
+inline UInt128 &UInt128::operator>>=(int shift)
+{
+    return *this = *this >> shift;
+}
+
+#endif // UINT128_H
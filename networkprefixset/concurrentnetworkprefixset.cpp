@@ -0,0 +1,64 @@
+#include "concurrentnetworkprefixset.h"
+
+ConcurrentNetworkPrefixSet::ConcurrentNetworkPrefixSet(const NetworkPrefixSet &prefixSet)
+: m_snapshot(new NetworkPrefixSet(prefixSet))
+, m_version(0)
+{
+}
+
+QSharedPointer<const NetworkPrefixSet> ConcurrentNetworkPrefixSet::snapshot() const
+{
+    QMutexLocker locker(&m_snapshotMutex);
+    return m_snapshot;
+}
+
+quint64 ConcurrentNetworkPrefixSet::version() const
+{
+    return m_version.loadAcquire();
+}
+
+void ConcurrentNetworkPrefixSet::publish(const NetworkPrefixSet &prefixSet)
+{
+    //the copy is made before any lock is taken
+    QSharedPointer<const NetworkPrefixSet> next(new NetworkPrefixSet(prefixSet));
+
+    QMutexLocker locker(&m_writerMutex);
+    swap(next);
+}
+
+void ConcurrentNetworkPrefixSet::swap(const QSharedPointer<const NetworkPrefixSet> &snapshot)
+{
+    QSharedPointer<const NetworkPrefixSet> previous;
+
+    {
+        QMutexLocker locker(&m_snapshotMutex);
+        previous = m_snapshot;
+        m_snapshot = snapshot;
+        m_version.fetchAndAddOrdered(1);
+    }
+
+    //previous is released here, outside of the lock; if this was the last
+    //reference, destroying a large set does not hold up the readers
+}
+
+ConcurrentNetworkPrefixSet::Reader::Reader(const ConcurrentNetworkPrefixSet *prefixSet)
+: m_prefixSet(prefixSet)
+, m_version(0)
+{
+    m_version = m_prefixSet->version();
+    m_snapshot = m_prefixSet->snapshot();
+}
+
+const NetworkPrefixSet &ConcurrentNetworkPrefixSet::Reader::current()
+{
+    //the version is read before the snapshot, so at worst a newer snapshot
+    //gets fetched once more on the next call
+    const quint64 version = m_prefixSet->version();
+
+    if (version != m_version) {
+        m_snapshot = m_prefixSet->snapshot();
+        m_version = version;
+    }
+
+    return *m_snapshot;
+}
@@ -0,0 +1,85 @@
+/**
+ * A NetworkPrefixSet shared between many reader threads and one or more
+ * writers, in read-copy-update style.
+ *
+ * Every published version is an immutable snapshot behind a shared pointer.
+ * Writers copy the current snapshot, change the copy and publish it, which
+ * swaps the pointer and bumps a version counter. A snapshot stays alive as
+ * long as anybody still holds it, so readers never see a half-applied update
+ * and old versions go away with their last reader.
+ *
+ * Each reader thread keeps its own Reader. A Reader holds on to the snapshot
+ * it last saw and only compares the atomic version counter on every lookup;
+ * the mutex is taken once per published version, not once per lookup, so
+ * reads scale with the number of cores. A Reader must not be shared between
+ * threads, and the ConcurrentNetworkPrefixSet has to outlive it.
+ */
+
+#ifndef CONCURRENTNETWORKPREFIXSET_H
+#define CONCURRENTNETWORKPREFIXSET_H
+
+#include <networkprefixset.h>
+
+#include <QAtomicInteger>
+#include <QMutex>
+#include <QSharedPointer>
+
+class ConcurrentNetworkPrefixSet
+{
+public:
+    class Reader;
+
+    explicit ConcurrentNetworkPrefixSet(const NetworkPrefixSet &prefixSet = NetworkPrefixSet());
+
+    //the current version, it does not change when a newer one is published
+    QSharedPointer<const NetworkPrefixSet> snapshot() const;
+    quint64 version() const;
+
+    //replaces the current version
+    void publish(const NetworkPrefixSet &prefixSet);
+
+    //copies the current version, lets function change the copy and publishes
+    //it; concurrent calls are serialized, so no update gets lost
+    template<typename Function>
+    void update(Function function);
+
+private:
+    Q_DISABLE_COPY(ConcurrentNetworkPrefixSet)
+
+    void swap(const QSharedPointer<const NetworkPrefixSet> &snapshot);
+
+    mutable QMutex m_snapshotMutex; //guards m_snapshot, only held to copy or swap it
+    QMutex m_writerMutex;           //serializes update()
+    QSharedPointer<const NetworkPrefixSet> m_snapshot;
+    QAtomicInteger<quint64> m_version;
+};
+
+class ConcurrentNetworkPrefixSet::Reader
+{
+public:
+    explicit Reader(const ConcurrentNetworkPrefixSet *prefixSet);
+
+    //the newest version, refreshed if a newer one was published since the
+    //last call; stays valid until the next call on this Reader
+    const NetworkPrefixSet &current();
+
+    NetworkPrefix longestPrefixMatch(QHostAddress address) { return current().longestPrefixMatch(address); }
+    bool contains(const NetworkPrefix &prefix) { return current().contains(prefix); }
+
+private:
+    const ConcurrentNetworkPrefixSet *m_prefixSet;
+    QSharedPointer<const NetworkPrefixSet> m_snapshot;
+    quint64 m_version;
+};
+
+template<typename Function>
+void ConcurrentNetworkPrefixSet::update(Function function)
+{
+    QMutexLocker locker(&m_writerMutex);
+
+    QSharedPointer<NetworkPrefixSet> next(new NetworkPrefixSet(*snapshot()));
+    function(*next);
+    swap(next);
+}
+
+#endif // CONCURRENTNETWORKPREFIXSET_H
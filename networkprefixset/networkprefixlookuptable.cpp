@@ -0,0 +1,110 @@
+#include "networkprefixlookuptable.h"
+
+#include <algorithm>
+
+NetworkPrefixLookupTable::NetworkPrefixLookupTable() {}
+
+NetworkPrefixLookupTable NetworkPrefixLookupTable::compile(const NetworkPrefixSet &prefixSet)
+{
+    NetworkPrefixLookupTable table;
+
+    for (const NetworkPrefix &prefix : prefixSet.toVector()) {
+        if (prefix.isIpv4()) {
+            table.m_prefixes.append(prefix);
+        }
+    }
+
+    if (table.m_prefixes.isEmpty()) {
+        return table;
+    }
+
+    //shorter prefixes are written first, so longer ones simply overwrite them
+    std::sort(table.m_prefixes.begin(),
+              table.m_prefixes.end(),
+              [](const NetworkPrefix &a, const NetworkPrefix &b) {
+                  if (a.prefixLength() != b.prefixLength()) {
+                      return a.prefixLength() < b.prefixLength();
+                  }
+                  return a.rawAddress() < b.rawAddress();
+              });
+    table.m_prefixes.erase(std::unique(table.m_prefixes.begin(), table.m_prefixes.end()),
+                           table.m_prefixes.end());
+
+    table.m_tbl24.fill(0, 1 << 24);
+    quint32 *tbl24 = table.m_tbl24.data();
+
+    for (int i = 0; i < table.m_prefixes.count(); ++i) {
+        const quint32 entry = static_cast<quint32>(i) + 1;
+        const quint32 address = static_cast<quint32>(table.m_prefixes[i].rawAddress().lo);
+        const int length = table.m_prefixes[i].prefixLength();
+
+        if (length <= 24) {
+            std::fill_n(tbl24 + (address >> 8), 1 << (24 - length), entry);
+            continue;
+        }
+
+        quint32 &slot = tbl24[address >> 8];
+        if (!(slot & ExtendedEntry)) {
+            //start a new group with whatever the /24 matched so far
+            const int group = table.m_tbl8.count() / 256;
+            table.m_tbl8.resize(table.m_tbl8.count() + 256);
+            std::fill_n(table.m_tbl8.begin() + group * 256, 256, slot);
+            slot = ExtendedEntry | static_cast<quint32>(group);
+        }
+
+        const int groupStart = static_cast<int>(slot & ~ExtendedEntry) * 256;
+        std::fill_n(table.m_tbl8.begin() + groupStart + (address & 0xff), 1 << (32 - length), entry);
+    }
+
+    return table;
+}
+
+NetworkPrefix NetworkPrefixLookupTable::longestPrefixMatch(QHostAddress address) const
+{
+    if (address.protocol() != QAbstractSocket::IPv4Protocol) {
+        return NetworkPrefix();
+    }
+
+    return longestPrefixMatch(address.toIPv4Address());
+}
+
+NetworkPrefix NetworkPrefixLookupTable::longestPrefixMatch(quint32 address) const
+{
+    const int index = lookup(address);
+
+    if (index < 0) {
+        return NetworkPrefix();
+    }
+
+    return m_prefixes[index];
+}
+
+int NetworkPrefixLookupTable::lookup(quint32 address) const
+{
+    if (m_tbl24.isEmpty()) {
+        return -1;
+    }
+
+    quint32 entry = m_tbl24.constData()[address >> 8];
+
+    if (entry & ExtendedEntry) {
+        entry = m_tbl8.constData()[(entry & ~ExtendedEntry) * 256 + (address & 0xff)];
+    }
+
+    return static_cast<int>(entry) - 1;
+}
+
+QVector<NetworkPrefix> NetworkPrefixLookupTable::prefixes() const
+{
+    return m_prefixes;
+}
+
+int NetworkPrefixLookupTable::prefixCount() const
+{
+    return m_prefixes.count();
+}
+
+bool NetworkPrefixLookupTable::isEmpty() const
+{
+    return m_prefixes.isEmpty();
+}
@@ -0,0 +1,46 @@
+/**
+ * Read-only IPv4 longest prefix match table, compiled from a NetworkPrefixSet.
+ *
+ * The layout is DIR-24-8: the first table has one entry per /24, so every
+ * lookup for a prefix of length 24 or shorter costs a single memory access.
+ * Slots covered by longer prefixes point to a group of 256 entries in a
+ * second table, which makes for a second access. Each entry is the index of
+ * the matching prefix, so results map back to a NetworkPrefix.
+ *
+ * The table is a snapshot: it does not follow later changes to the set it was
+ * compiled from and has to be compiled again. IPv6 prefixes are ignored, use
+ * NetworkPrefixSet::longestPrefixMatch() for those. Note that the first table
+ * alone takes 64 MB as soon as the set holds an IPv4 prefix.
+ */
+
+#ifndef NETWORKPREFIXLOOKUPTABLE_H
+#define NETWORKPREFIXLOOKUPTABLE_H
+
+#include <networkprefixset.h>
+
+class NetworkPrefixLookupTable
+{
+public:
+    explicit NetworkPrefixLookupTable();
+
+    static NetworkPrefixLookupTable compile(const NetworkPrefixSet &prefixSet);
+
+    NetworkPrefix longestPrefixMatch(QHostAddress address) const;
+    NetworkPrefix longestPrefixMatch(quint32 address) const;
+
+    //index of the longest matching prefix in prefixes() or -1
+    int lookup(quint32 address) const;
+
+    QVector<NetworkPrefix> prefixes() const;
+    int prefixCount() const;
+    bool isEmpty() const;
+
+private:
+    static const quint32 ExtendedEntry = 0x80000000;
+
+    QVector<quint32> m_tbl24;
+    QVector<quint32> m_tbl8;
+    QVector<NetworkPrefix> m_prefixes;
+};
+
+#endif // NETWORKPREFIXLOOKUPTABLE_H
@@ -0,0 +1,239 @@
+/**
+ * Maps network prefixes to values of any type, with exact and longest prefix
+ * match lookups, e.g. to attach an ASN or a policy to every prefix.
+ *
+ * Values are kept in one contiguous vector, next to a vector of their keys; a
+ * NetworkPrefixTrie maps every prefix to its index in there. A lookup is a
+ * trie walk followed by a single access into the value vector. Removing an
+ * entry moves the last one into its place, so the vectors never have holes,
+ * but pointers to values are only valid until the map is changed.
+ *
+ * Iteration is in prefix order: IPv4 first, then by address, and shorter
+ * prefixes before the longer ones they contain. begin() computes that order,
+ * which takes O(n); iterators are invalidated by changes to the map.
+ */
+
+#ifndef NETWORKPREFIXMAP_H
+#define NETWORKPREFIXMAP_H
+
+#include <networkprefix.h>
+#include <networkprefixtrie.h>
+
+#include <QDebug>
+#include <QVector>
+
+#include <iterator>
+#include <utility>
+
+template<typename T>
+class NetworkPrefixMap
+{
+public:
+    class const_iterator;
+
+    explicit NetworkPrefixMap() {}
+
+    //replaces the value if the prefix is already in the map, invalid
+    //prefixes are ignored
+    void insert(const NetworkPrefix &prefix, const T &value);
+    bool remove(const NetworkPrefix &prefix);
+    void clear();
+
+    bool contains(const NetworkPrefix &prefix) const { return m_trie.value(prefix) >= 0; }
+    T value(const NetworkPrefix &prefix, const T &defaultValue = T()) const;
+    //inserts a default constructed value if the prefix is not in the map yet;
+    //an invalid prefix cannot be a key, it gets a warning and a default
+    //constructed spare value that no lookup returns
+    T &operator[](const NetworkPrefix &prefix);
+
+    //nullptr if the prefix is not in the map
+    T *find(const NetworkPrefix &prefix);
+    const T *find(const NetworkPrefix &prefix) const;
+
+    //the value of the longest prefix containing address, nullptr if none does
+    T *longestPrefixMatch(const QHostAddress &address, NetworkPrefix *matchedPrefix = nullptr);
+    const T *longestPrefixMatch(const QHostAddress &address, NetworkPrefix *matchedPrefix = nullptr) const;
+
+    int count() const { return m_keys.count(); }
+    bool isEmpty() const { return m_keys.isEmpty(); }
+
+    //in prefix order
+    QVector<NetworkPrefix> keys() const;
+
+    const_iterator begin() const { return const_iterator(this, m_trie.values(), 0); }
+    const_iterator end() const { return const_iterator(this, QVector<int>(), count()); }
+
+private:
+    NetworkPrefixTrie m_trie; //prefix to index into m_keys and m_values
+    QVector<NetworkPrefix> m_keys;
+    QVector<T> m_values;
+    T m_spare; //what operator[] hands out for invalid prefixes
+};
+
+template<typename T>
+class NetworkPrefixMap<T>::const_iterator
+{
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef std::ptrdiff_t difference_type;
+    typedef T value_type;
+    typedef const T *pointer;
+    typedef const T &reference;
+
+    const_iterator()
+    : m_map(nullptr)
+    , m_position(0)
+    {}
+
+    const NetworkPrefix &key() const { return m_map->m_keys[m_order[m_position]]; }
+    const T &value() const { return m_map->m_values[m_order[m_position]]; }
+    const T &operator*() const { return value(); }
+    const T *operator->() const { return &value(); }
+
+    const_iterator &operator++()
+    {
+        ++m_position;
+        return *this;
+    }
+    const_iterator operator++(int)
+    {
+        const_iterator previous = *this;
+        ++m_position;
+        return previous;
+    }
+
+    bool operator==(const const_iterator &other) const { return m_position == other.m_position; }
+    bool operator!=(const const_iterator &other) const { return m_position != other.m_position; }
+
+private:
+    friend class NetworkPrefixMap<T>;
+
+    const_iterator(const NetworkPrefixMap<T> *map, const QVector<int> &order, int position)
+    : m_map(map)
+    , m_order(order)
+    , m_position(position)
+    {}
+
+    const NetworkPrefixMap<T> *m_map;
+    QVector<int> m_order; //indexes into the map's vectors in prefix order
+    int m_position;
+};
+
+template<typename T>
+void NetworkPrefixMap<T>::insert(const NetworkPrefix &prefix, const T &value)
+{
+    if (!prefix.isValid()) {
+        return;
+    }
+
+    const int index = m_trie.value(prefix);
+    if (index >= 0) {
+        m_values[index] = value;
+        return;
+    }
+
+    m_trie.insert(prefix, m_keys.count());
+    m_keys.append(prefix);
+    m_values.append(value);
+}
+
+template<typename T>
+bool NetworkPrefixMap<T>::remove(const NetworkPrefix &prefix)
+{
+    const int index = m_trie.value(prefix);
+    if (index < 0) {
+        return false;
+    }
+
+    m_trie.remove(prefix);
+
+    //the last entry fills the hole
+    const int last = m_keys.count() - 1;
+    if (index != last) {
+        m_keys[index] = m_keys[last];
+        m_values[index] = std::move(m_values[last]);
+        m_trie.insert(m_keys[index], index);
+    }
+
+    m_keys.removeLast();
+    m_values.removeLast();
+    return true;
+}
+
+template<typename T>
+void NetworkPrefixMap<T>::clear()
+{
+    m_trie.clear();
+    m_keys.clear();
+    m_values.clear();
+}
+
+template<typename T>
+T NetworkPrefixMap<T>::value(const NetworkPrefix &prefix, const T &defaultValue) const
+{
+    const int index = m_trie.value(prefix);
+    return index >= 0 ? m_values[index] : defaultValue;
+}
+
+template<typename T>
+T &NetworkPrefixMap<T>::operator[](const NetworkPrefix &prefix)
+{
+    if (!prefix.isValid()) {
+        qWarning() << "NetworkPrefixMap: an invalid prefix cannot be a key";
+        m_spare = T();
+        return m_spare;
+    }
+
+    int index = m_trie.value(prefix);
+
+    if (index < 0) {
+        insert(prefix, T());
+        index = m_trie.value(prefix);
+    }
+
+    return m_values[index];
+}
+
+template<typename T>
+T *NetworkPrefixMap<T>::find(const NetworkPrefix &prefix)
+{
+    const int index = m_trie.value(prefix);
+    return index >= 0 ? &m_values[index] : nullptr;
+}
+
+template<typename T>
+const T *NetworkPrefixMap<T>::find(const NetworkPrefix &prefix) const
+{
+    const int index = m_trie.value(prefix);
+    return index >= 0 ? &m_values[index] : nullptr;
+}
+
+template<typename T>
+T *NetworkPrefixMap<T>::longestPrefixMatch(const QHostAddress &address, NetworkPrefix *matchedPrefix)
+{
+    const int index = m_trie.longestPrefixMatch(address, matchedPrefix);
+    return index >= 0 ? &m_values[index] : nullptr;
+}
+
+template<typename T>
+const T *NetworkPrefixMap<T>::longestPrefixMatch(const QHostAddress &address,
+                                                 NetworkPrefix *matchedPrefix) const
+{
+    const int index = m_trie.longestPrefixMatch(address, matchedPrefix);
+    return index >= 0 ? &m_values[index] : nullptr;
+}
+
+template<typename T>
+QVector<NetworkPrefix> NetworkPrefixMap<T>::keys() const
+{
+    QVector<NetworkPrefix> keys;
+    keys.reserve(count());
+
+    for (const int index : m_trie.values()) {
+        keys.append(m_keys[index]);
+    }
+
+    return keys;
+}
+
+#endif // NETWORKPREFIXMAP_H
@@ -0,0 +1,442 @@
+#include "networkprefixparser.h"
+
+#include <QThread>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cstring>
+
+//the fast path below only accepts forms where it is certain to agree with
+//QHostAddress::parseSubnet(); everything it rejects goes through parseSubnet()
+namespace {
+
+enum FastResult { Parsed, NotHandled };
+
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+//1 to 3 decimal digits; leading zeros are fine for QString::toUInt(), but not
+//for the parser QHostAddress uses on netmasks and IPv4 tails, which reads them
+//as octal
+bool parseDecimal(const char *&p, const char *end, bool allowLeadingZero, uint *value)
+{
+    const char *start = p;
+    uint result = 0;
+
+    while (p != end && isDigit(*p) && p - start < 3) {
+        result = result * 10 + static_cast<uint>(*p - '0');
+        ++p;
+    }
+
+    if (p == start || (p != end && isDigit(*p))) {
+        return false;
+    }
+
+    if (!allowLeadingZero && *start == '0' && p - start > 1) {
+        return false;
+    }
+
+    *value = result;
+    return true;
+}
+
+//exactly four parts, as in netmasks and embedded IPv4 addresses
+bool parseDottedQuad(const char *p, const char *end, quint32 *address)
+{
+    quint32 result = 0;
+
+    for (int i = 0; i < 4; ++i) {
+        uint part;
+        if (!parseDecimal(p, end, false, &part) || part > 255) {
+            return false;
+        }
+
+        result = (result << 8) | part;
+
+        if (i < 3) {
+            if (p == end || *p != '.') {
+                return false;
+            }
+            ++p;
+        }
+    }
+
+    if (p != end) {
+        return false;
+    }
+
+    *address = result;
+    return true;
+}
+
+//the short forms of parseSubnet(): "10", "10.", "10.1", "10.1.2." and so on,
+//missing parts are zero
+bool parseIpv4(const char *p, const char *end, quint32 *address, int *partCount)
+{
+    quint32 result = 0;
+    int count = 0;
+
+    if (p == end) {
+        return false;
+    }
+
+    for (;;) {
+        uint part;
+        if (!parseDecimal(p, end, true, &part) || part > 255) {
+            return false;
+        }
+
+        result = (result << 8) | part;
+        ++count;
+
+        if (p == end) {
+            break;
+        }
+
+        if (*p != '.' || count == 4) {
+            return false;
+        }
+
+        ++p;
+
+        if (p == end) {
+            break;
+        }
+    }
+
+    *address = count == 4 ? result : result << (8 * (4 - count));
+    *partCount = count;
+    return true;
+}
+
+bool parseIpv6(const char *p, const char *end, UInt128 *address)
+{
+    quint16 words[8];
+    int count = 0;
+    int gap = -1;
+
+    if (p == end) {
+        return false;
+    }
+
+    if (*p == ':') {
+        if (end - p < 2 || p[1] != ':') {
+            return false;
+        }
+        gap = 0;
+        p += 2;
+    }
+
+    while (p != end) {
+        const char *q = p;
+        uint word = 0;
+        int digit;
+
+        while (q != end && q - p < 5 && (digit = hexValue(*q)) >= 0) {
+            word = (word << 4) | static_cast<uint>(digit);
+            ++q;
+        }
+
+        //an IPv4 tail takes the last two words
+        if (q != end && *q == '.') {
+            quint32 ipv4;
+            if (count > 6 || !parseDottedQuad(p, end, &ipv4)) {
+                return false;
+            }
+
+            words[count++] = static_cast<quint16>(ipv4 >> 16);
+            words[count++] = static_cast<quint16>(ipv4);
+            break;
+        }
+
+        if (q == p || q - p > 4 || count == 8) {
+            return false;
+        }
+
+        words[count++] = static_cast<quint16>(word);
+        p = q;
+
+        if (p == end) {
+            break;
+        }
+
+        if (*p != ':' || ++p == end) {
+            return false;
+        }
+
+        if (*p == ':') {
+            if (gap >= 0) {
+                return false;
+            }
+            gap = count;
+            ++p;
+        }
+    }
+
+    //"::" has to stand for at least one word
+    if (gap < 0 ? count != 8 : count > 7) {
+        return false;
+    }
+
+    UInt128 result;
+    const int fill = 8 - count;
+    for (int i = 0, word = 0; i < 8; ++i) {
+        result <<= 16;
+        if (gap >= 0 && i >= gap && i < gap + fill) {
+            continue;
+        }
+        result |= words[word++];
+    }
+
+    *address = result;
+    return true;
+}
+
+FastResult parseFast(const char *begin, const char *end, NetworkPrefix *prefix)
+{
+    const char *slash = static_cast<const char *>(memchr(begin, '/', static_cast<size_t>(end - begin)));
+    const char *addressEnd = slash ? slash : end;
+    const bool isIpv6 = memchr(begin, ':', static_cast<size_t>(addressEnd - begin)) != nullptr;
+    int prefixLength = -1;
+
+    if (slash) {
+        const char *p = slash + 1;
+        const bool dotted = memchr(p, '.', static_cast<size_t>(end - p)) != nullptr;
+
+        if (!isIpv6 && dotted) {
+            quint32 netmask;
+            if (!parseDottedQuad(p, end, &netmask)) {
+                return NotHandled;
+            }
+
+            prefixLength = static_cast<int>(qCountLeadingZeroBits(~netmask));
+            if (prefixLength < 32 && (netmask << prefixLength) != 0) {
+                *prefix = NetworkPrefix();
+                return Parsed;
+            }
+        } else {
+            uint length;
+            if (!parseDecimal(p, end, true, &length) || p != end) {
+                return NotHandled;
+            }
+            prefixLength = static_cast<int>(length);
+        }
+    }
+
+    if (isIpv6) {
+        UInt128 address;
+        if (prefixLength > 128 || !parseIpv6(begin, addressEnd, &address)) {
+            return NotHandled;
+        }
+
+        *prefix = NetworkPrefix::fromIpv6(address, prefixLength < 0 ? 128 : prefixLength);
+        return Parsed;
+    }
+
+    quint32 address;
+    int partCount;
+    if (prefixLength > 32 || !parseIpv4(begin, addressEnd, &address, &partCount)) {
+        return NotHandled;
+    }
+
+    *prefix = NetworkPrefix::fromIpv4(address, prefixLength < 0 ? 8 * partCount : prefixLength);
+    return Parsed;
+}
+
+} // namespace
+
+NetworkPrefixParser::NetworkPrefixParser(bool skipUnparsableLines, const QByteArray &startOfComment)
+: m_skipUnparsableLines(skipUnparsableLines)
+, m_startOfComment(startOfComment)
+{
+}
+
+NetworkPrefix NetworkPrefixParser::parsePrefix(const char *begin, const char *end)
+{
+    NetworkPrefix prefix;
+
+    if (parseFast(begin, end, &prefix) == Parsed) {
+        return prefix;
+    }
+
+    return NetworkPrefix(QString::fromUtf8(begin, static_cast<int>(end - begin)));
+}
+
+NetworkPrefix NetworkPrefixParser::parsePrefix(const QByteArray &text)
+{
+    return parsePrefix(text.constData(), text.constData() + text.size());
+}
+
+bool NetworkPrefixParser::parse(const char *begin, const char *end, int firstLine)
+{
+    int line = firstLine;
+
+    while (begin < end) {
+        //memchr is vectorized in any libc worth using
+        const char *newline = static_cast<const char *>(
+            memchr(begin, '\n', static_cast<size_t>(end - begin)));
+        const char *lineEnd = newline ? newline : end;
+
+        if (!parseLine(begin, lineEnd, line)) {
+            return false;
+        }
+
+        begin = newline ? newline + 1 : end;
+        ++line;
+    }
+
+    return true;
+}
+
+bool NetworkPrefixParser::parse(const QByteArray &data, int firstLine)
+{
+    return parse(data.constData(), data.constData() + data.size(), firstLine);
+}
+
+bool NetworkPrefixParser::parseParallel(const char *begin, const char *end, int firstLine, int chunkCount)
+{
+    struct Chunk
+    {
+        const char *begin;
+        const char *end;
+        int lineCount;
+        NetworkPrefixParser parser;
+    };
+
+    //small inputs are not worth the threads
+    const qint64 size = end - begin;
+    if (chunkCount <= 0) {
+        chunkCount = qMax(1, QThread::idealThreadCount());
+    }
+    if (size < 64 * 1024) {
+        chunkCount = 1;
+    }
+
+    QVector<Chunk> chunks;
+    chunks.reserve(chunkCount);
+
+    //cut at the first newline after each even split point, so no line is torn
+    const char *chunkBegin = begin;
+    for (int i = 1; i <= chunkCount && chunkBegin < end; ++i) {
+        const char *chunkEnd = i == chunkCount ? end : qMax(chunkBegin, begin + size * i / chunkCount);
+        const char *newline = static_cast<const char *>(
+            memchr(chunkEnd, '\n', static_cast<size_t>(end - chunkEnd)));
+        chunkEnd = newline ? newline + 1 : end;
+
+        Chunk chunk;
+        chunk.begin = chunkBegin;
+        chunk.end = chunkEnd;
+        chunk.lineCount = 0;
+        chunk.parser = NetworkPrefixParser(m_skipUnparsableLines, m_startOfComment);
+        chunks.append(chunk);
+
+        chunkBegin = chunkEnd;
+    }
+
+    QtConcurrent::blockingMap(chunks, [](Chunk &chunk) {
+        chunk.parser.parse(chunk.begin, chunk.end);
+        chunk.lineCount = static_cast<int>(std::count(chunk.begin, chunk.end, '\n'));
+    });
+
+    //merge in file order, up to and including the first chunk with an error
+    //if those are not skipped, which leaves the same result as parse()
+    int lineOffset = firstLine - 1;
+    for (const Chunk &chunk : chunks) {
+        m_prefixes += chunk.parser.m_prefixes;
+
+        for (Error error : chunk.parser.m_errors) {
+            error.line += lineOffset;
+            m_errors.append(error);
+        }
+
+        if (!m_skipUnparsableLines && !chunk.parser.m_errors.isEmpty()) {
+            return false;
+        }
+
+        lineOffset += chunk.lineCount;
+    }
+
+    return true;
+}
+
+QVector<NetworkPrefix> NetworkPrefixParser::prefixes() const
+{
+    return m_prefixes;
+}
+
+QVector<NetworkPrefixParser::Error> NetworkPrefixParser::errors() const
+{
+    return m_errors;
+}
+
+void NetworkPrefixParser::clear()
+{
+    m_prefixes.clear();
+    m_errors.clear();
+}
+
+bool NetworkPrefixParser::parseLine(const char *begin, const char *end, int line)
+{
+    while (begin != end && isSpace(*begin)) {
+        ++begin;
+    }
+    while (end != begin && isSpace(end[-1])) {
+        --end;
+    }
+
+    if (begin == end) {
+        return true;
+    }
+
+    if (end - begin >= m_startOfComment.size()
+        && memcmp(begin, m_startOfComment.constData(), static_cast<size_t>(m_startOfComment.size())) == 0) {
+        return true;
+    }
+
+    NetworkPrefix prefix;
+    if (parseFast(begin, end, &prefix) == Parsed && prefix.isValid()) {
+        m_prefixes.append(prefix);
+        return true;
+    }
+
+    //the slow path does exactly what fromFile() used to do on every line,
+    //which also covers whitespace and comments behind non-ASCII whitespace
+    const QString text = QString::fromUtf8(begin, static_cast<int>(end - begin)).trimmed();
+    if (text.isEmpty() || text.startsWith(QString::fromUtf8(m_startOfComment))) {
+        return true;
+    }
+
+    prefix = NetworkPrefix(text);
+    if (prefix.isValid()) {
+        m_prefixes.append(prefix);
+        return true;
+    }
+
+    Error error;
+    error.line = line;
+    error.text = QByteArray(begin, static_cast<int>(end - begin));
+    m_errors.append(error);
+
+    return m_skipUnparsableLines;
+}
@@ -0,0 +1,64 @@
+/**
+ * Parses prefixes straight from bytes, without going through QString and
+ * QHostAddress::parseSubnet() for every line.
+ *
+ * Dotted quads (including the short forms like "10.0" for 10.0.0.0/16), IPv6
+ * text with or without an embedded IPv4 tail, prefix lengths and dotted IPv4
+ * netmasks are parsed directly into the integer representation. Anything
+ * beyond those common forms, like scope ids, is handed to parseSubnet(), so
+ * the parser accepts exactly what parseSubnet() accepts and the fast path only
+ * decides how quickly that happens.
+ */
+
+#ifndef NETWORKPREFIXPARSER_H
+#define NETWORKPREFIXPARSER_H
+
+#include <networkprefix.h>
+
+#include <QByteArray>
+#include <QVector>
+
+class NetworkPrefixParser
+{
+public:
+    struct Error
+    {
+        int line;
+        QByteArray text;
+    };
+
+    explicit NetworkPrefixParser(bool skipUnparsableLines = false,
+                                 const QByteArray &startOfComment = "#");
+
+    //a single prefix, a null prefix if it cannot be parsed
+    static NetworkPrefix parsePrefix(const char *begin, const char *end);
+    static NetworkPrefix parsePrefix(const QByteArray &text);
+
+    //one prefix per line, surrounding whitespace, empty lines and comments are
+    //ignored. Stops and returns false at the first unparsable line, unless
+    //those are skipped. firstLine numbers the lines in errors(), in case data
+    //is only a part of a file.
+    bool parse(const char *begin, const char *end, int firstLine = 1);
+    bool parse(const QByteArray &data, int firstLine = 1);
+
+    //same as parse(), but the data is cut at line boundaries into chunks which
+    //are parsed on all cores; prefixes and errors come out in file order.
+    //chunkCount 0 means one chunk per core.
+    bool parseParallel(const char *begin, const char *end, int firstLine = 1, int chunkCount = 0);
+
+    QVector<NetworkPrefix> prefixes() const;
+    QVector<Error> errors() const;
+    void clear();
+
+private:
+    bool parseLine(const char *begin, const char *end, int line);
+
+    bool m_skipUnparsableLines;
+    QByteArray m_startOfComment;
+    QVector<NetworkPrefix> m_prefixes;
+    QVector<Error> m_errors;
+};
+
+Q_DECLARE_TYPEINFO(NetworkPrefixParser::Error, Q_MOVABLE_TYPE);
+
+#endif // NETWORKPREFIXPARSER_H
@@ -1,21 +1,94 @@
 #include "networkprefixset.h"
 
+#include <networkprefixparser.h>
+#include <networkprefixsetfile.h>
+#include <prefixmath.h>
+
+#include <QAtomicInt>
 #include <QFile>
 #include <QLoggingCategory>
-#include <QtMath>
+#include <QMutex>
+
+#include <algorithm>
+#include <limits>
+#include <utility>
 
 Q_LOGGING_CATEGORY(networkprefixset_log, "networkprefixset");
 
+static NetworkAddressRange makeRange(bool ipv4, const UInt128 &first, const UInt128 &last)
+{
+    return ipv4 ? NetworkAddressRange::fromIpv4(static_cast<quint32>(first.lo), static_cast<quint32>(last.lo))
+                : NetworkAddressRange::fromIpv6(first, last);
+}
+
+class NetworkPrefixSetData : public QSharedData
+{
+public:
+    NetworkPrefixSetData()
+    : m_coverageValid(0)
+    {}
+    //the cache is not copied, a detached copy is about to be changed anyway
+    NetworkPrefixSetData(const NetworkPrefixSetData &other)
+    : QSharedData(other)
+    , m_prefixSet(other.m_prefixSet)
+    , m_counts(other.m_counts)
+    , m_trie(other.m_trie)
+    , m_coverageValid(0)
+    {}
+
+    QVector<NetworkPrefix> m_prefixSet;
+    QHash<NetworkPrefix, int> m_counts; //how often each prefix is in m_prefixSet
+    NetworkPrefixTrie m_trie;           //every prefix in m_prefixSet once, for the longest prefix match
+
+    //coveredAddressCount() of both families; readers of a shared set may fill
+    //it concurrently, the mutex makes sure only one of them does the sort
+    mutable QMutex m_coverageMutex;
+    mutable QAtomicInt m_coverageValid;
+    mutable UInt128 m_ipv4Coverage;
+    mutable UInt128 m_ipv6Coverage;
+};
+
+//the data of every moved-from set, like the shared null of Qt's containers;
+//building it allocates nothing, and the reference it holds on itself keeps
+//it from ever being deleted. Changing a set that uses it detaches first
+static NetworkPrefixSetData *sharedEmptyData() noexcept
+{
+    static NetworkPrefixSetData empty;
+    static const bool pinned = empty.ref.ref();
+    Q_UNUSED(pinned);
+
+    return &empty;
+}
+
 NetworkPrefixSet::NetworkPrefixSet()
-: m_currentPrefix(0)
+: d(new NetworkPrefixSetData)
+{
+}
+
+NetworkPrefixSet::NetworkPrefixSet(const NetworkPrefixSet &other) = default;
+
+NetworkPrefixSet::NetworkPrefixSet(NetworkPrefixSet &&other) noexcept
+: d(sharedEmptyData())
+{
+    swap(other);
+}
+
+NetworkPrefixSet::~NetworkPrefixSet() = default;
+
+NetworkPrefixSet &NetworkPrefixSet::operator=(const NetworkPrefixSet &other) = default;
+
+NetworkPrefixSet &NetworkPrefixSet::operator=(NetworkPrefixSet &&other) noexcept
 {
+    //other gets the shared empty data and our old data goes away with moved
+    NetworkPrefixSet moved(std::move(other));
+    swap(moved);
+    return *this;
 }
 
 //NetworkPrefixSet::NetworkPrefixSet(QString &fileName,
 //                                   bool skipUnparsableLines,
 //                                   bool allowDuplicates,
 //                                   QString startOfComment)
-//: m_currentPrefix(0)
 //{
 //    loadPrefixSetFromFile(fileName, skipUnparsableLines, allowDuplicates, startOfComment);
 //}
@@ -28,314 +101,717 @@ NetworkPrefixSet NetworkPrefixSet::fromFile(QString fileName,
     NetworkPrefixSet returnSet;
     QFile file(fileName);
 
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (!file.open(QIODevice::ReadOnly)) {
         qCWarning(networkprefixset_log) << "Unable to open file " << fileName;
         return returnSet;
     }
 
-    while (!file.atEnd()) {
-        QString line = file.readLine();
+    //parse the raw bytes in one go instead of a QString per line
+    const QByteArray data = file.readAll();
+    file.close();
 
-        line = line.trimmed();
+    return fromData(data.constData(),
+                    data.constData() + data.size(),
+                    false,
+                    skipUnparsableLines,
+                    allowDuplicates,
+                    startOfComment);
+}
 
-        //ignore empty lines
-        if (line.isEmpty()) {
-            continue;
-        }
+NetworkPrefixSet NetworkPrefixSet::fromFileParallel(QString fileName,
+                                                    bool skipUnparsableLines,
+                                                    bool allowDuplicates,
+                                                    QString startOfComment)
+{
+    QFile file(fileName);
 
-        //ignore comments
-        if (line.startsWith(startOfComment)) {
-            continue;
-        }
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(networkprefixset_log) << "Unable to open file " << fileName;
+        return NetworkPrefixSet();
+    }
 
-        NetworkPrefix prefix(line);
+    if (file.size() == 0) {
+        return NetworkPrefixSet();
+    }
 
-        if (prefix.isValid()) {
-            if (!allowDuplicates) {
-                if (!returnSet.contains(prefix)) {
-                    returnSet.addPrefix(prefix);
-                }
-            } else {
-                returnSet.addPrefix(prefix);
-            }
-        } else {
-            if (!skipUnparsableLines) {
-                qCWarning(networkprefixset_log)
-                    << QString("Stopped parsing, because of: %1").arg(QString(line));
-                returnSet.clear();
-                file.close();
-                return returnSet;
-            }
-        }
+    //resources and some special files cannot be mapped, read those instead
+    const uchar *mapped = file.map(0, file.size());
+    if (!mapped) {
+        const QByteArray data = file.readAll();
+        return fromData(data.constData(),
+                        data.constData() + data.size(),
+                        true,
+                        skipUnparsableLines,
+                        allowDuplicates,
+                        startOfComment);
     }
 
-    file.close();
-    return returnSet;
+    const char *begin = reinterpret_cast<const char *>(mapped);
+    return fromData(begin,
+                    begin + file.size(),
+                    true,
+                    skipUnparsableLines,
+                    allowDuplicates,
+                    startOfComment);
 }
 
-NetworkPrefixSet NetworkPrefixSet::fromVector(QVector<NetworkPrefix> &prefixes,
+NetworkPrefixSet NetworkPrefixSet::fromData(const char *begin,
+                                            const char *end,
+                                            bool parallel,
+                                            bool skipUnparsableLines,
+                                            bool allowDuplicates,
+                                            const QString &startOfComment)
+{
+    NetworkPrefixSet returnSet;
+    NetworkPrefixParser parser(skipUnparsableLines, startOfComment.toUtf8());
+
+    if (!(parallel ? parser.parseParallel(begin, end) : parser.parse(begin, end))) {
+        const NetworkPrefixParser::Error error = parser.errors().last();
+        qCWarning(networkprefixset_log)
+            << QString("Stopped parsing at line %1, because of: %2")
+                   .arg(error.line)
+                   .arg(QString(error.text));
+        return returnSet;
+    }
+
+    //the parser only hands out valid prefixes
+    return fromVector(parser.prefixes(), allowDuplicates, false);
+}
+
+NetworkPrefixSet NetworkPrefixSet::fromVector(const QVector<NetworkPrefix> &prefixes,
+                                              bool allowDuplicates,
+                                              bool removeNullPrefixes)
+{
+    //the copy is shared, it only detaches if a prefix has to be dropped
+    return fromVector(QVector<NetworkPrefix>(prefixes), allowDuplicates, removeNullPrefixes);
+}
+
+NetworkPrefixSet NetworkPrefixSet::fromVector(QVector<NetworkPrefix> &&prefixes,
                                               bool allowDuplicates,
                                               bool removeNullPrefixes)
 {
     NetworkPrefixSet returnSet;
+    QVector<NetworkPrefix> &kept = returnSet.d->m_prefixSet;
+    kept = std::move(prefixes);
 
-    if (prefixes.count() == 0) {
-        return returnSet;
-    }
+    //compact in place, nothing is written as long as every prefix is kept
+    int count = 0;
+    for (int i = 0; i < kept.count(); ++i) {
+        const NetworkPrefix prefix = kept.at(i);
 
-    if (!allowDuplicates || removeNullPrefixes) {
-        for (NetworkPrefix prefix : prefixes) {
-            if (!allowDuplicates && returnSet.contains(prefix)) {
-                continue;
-            }
-            if (removeNullPrefixes && !prefix.isValid()) {
-                continue;
-            }
-            returnSet.m_prefixSet.append(prefix);
+        if (removeNullPrefixes && !prefix.isValid()) {
+            continue;
         }
-    } else {
-        returnSet.m_prefixSet = prefixes;
+        if (!allowDuplicates && returnSet.contains(prefix)) {
+            continue;
+        }
+
+        if (count != i) {
+            kept[count] = prefix;
+        }
+        returnSet.indexPrefix(prefix);
+        ++count;
+    }
+
+    if (count < kept.count()) {
+        kept.resize(count);
     }
 
     return returnSet;
 }
 
+NetworkPrefixSet NetworkPrefixSet::fromBinaryFile(const QString &fileName)
+{
+    NetworkPrefixSetFile file;
+
+    if (!file.open(fileName)) {
+        qCWarning(networkprefixset_log) << "Unable to open binary prefix file " << fileName;
+        return NetworkPrefixSet();
+    }
+
+    return file.toSet();
+}
+
+bool NetworkPrefixSet::toBinaryFile(const QString &fileName) const
+{
+    if (!NetworkPrefixSetFile::save(*this, fileName)) {
+        qCWarning(networkprefixset_log) << "Unable to write binary prefix file " << fileName;
+        return false;
+    }
+
+    return true;
+}
+
 QVector<NetworkPrefix> NetworkPrefixSet::toVector() const
 {
-    return m_prefixSet;
+    return d->m_prefixSet;
 }
 
 void NetworkPrefixSet::addPrefix(NetworkPrefix prefix, bool allowDuplicates)
 {
     if (!allowDuplicates) {
-        if (m_prefixSet.contains(prefix)) {
+        if (contains(prefix)) {
             return;
         }
     }
 
-    m_prefixSet.append(prefix);
+    d->m_prefixSet.append(prefix);
+    indexPrefix(prefix);
 }
 
 void NetworkPrefixSet::removePrefix(NetworkPrefix prefix, bool removeDuplicates)
 {
     //TODO: test, in particular consecutive Prefixes to be removed and prefix at the end
+    if (!contains(prefix)) {
+        return;
+    }
+
     int index = 0;
-    while ((index = m_prefixSet.indexOf(prefix, index)) >= 0) {
-        m_prefixSet.remove(index);
+    while ((index = d->m_prefixSet.indexOf(prefix, index)) >= 0) {
+        d->m_prefixSet.remove(index);
+        unindexPrefix(prefix);
         if (!removeDuplicates) {
             break;
         }
     }
 }
 
-bool NetworkPrefixSet::contains(NetworkPrefix prefix)
+bool NetworkPrefixSet::contains(NetworkPrefix prefix) const
+{
+    return d->m_counts.contains(prefix);
+}
+
+NetworkPrefix NetworkPrefixSet::longestPrefixMatch(QHostAddress address) const
+{
+    //the trie walk only depends on the address length, not on the size of the set
+    NetworkPrefix returnPrefix;
+    d->m_trie.longestPrefixMatch(address, &returnPrefix);
+    return returnPrefix;
+}
+
+void NetworkPrefixSet::longestPrefixMatches(const quint32 *addresses, int count, NetworkPrefix *matches) const
+{
+    d->m_trie.longestPrefixMatches(addresses, count, nullptr, matches);
+}
+
+void NetworkPrefixSet::longestPrefixMatches(const Q_IPV6ADDR *addresses, int count, NetworkPrefix *matches) const
 {
-    return m_prefixSet.contains(prefix);
+    d->m_trie.longestPrefixMatches(addresses, count, nullptr, matches);
 }
 
-QHostAddress NetworkPrefixSet::nextAddress()
+bool NetworkPrefixSet::isCoveredBySet(NetworkPrefix prefix) const
 {
     //TODO: test
 
-    //skip over invalid prefixes
-    while (m_currentPrefix < m_prefixSet.count() && !m_prefixSet[m_currentPrefix].isValid()) {
-        ++m_currentPrefix;
+    for (const NetworkPrefix &prefixFromSet : d->m_prefixSet) {
+        if (prefixFromSet.containsPrefix(prefix)) {
+            return true;
+        }
     }
 
-    //did we reach the end?
-    if (m_currentPrefix >= m_prefixSet.count()) {
-        return QHostAddress();
+    return false;
+}
+
+int NetworkPrefixSet::prefixCount() const
+{
+    return d->m_prefixSet.count();
+}
+
+QVector<NetworkPrefixShard> NetworkPrefixSet::split(int count) const
+{
+    QVector<NetworkPrefixShard> shards;
+
+    if (count <= 0) {
+        return shards;
     }
 
-    if (m_prefixSet[m_currentPrefix].hasMoreAddresses()) {
-        return m_prefixSet[m_currentPrefix].nextAddress();
-    } else {
-        //m_prefixSet[m_currentPrefix].resetIterator();  //do or don't?
-        ++m_currentPrefix;
-        return nextAddress();
+    //same balancing as NetworkAddressRange::split(), the first remainder
+    //shards get one address more, but shards may span several prefixes
+    UInt128 remainder;
+    const UInt128 size = UInt128::divide(addressCount(), static_cast<quint64>(count), &remainder);
+    UInt128 needed = remainder.isZero() ? size : size + 1;
+    NetworkPrefixShard shard;
+
+    for (const NetworkPrefix &prefix : d->m_prefixSet) {
+        NetworkAddressRange rest = prefix.toRange();
+
+        while (rest.isValid()) {
+            const UInt128 available = rest.addressCount();
+
+            //the last shard takes everything left, in case the count saturated
+            if (shards.count() == count - 1 || available < needed || needed.isZero()) {
+                shard.appendRange(rest);
+                needed -= available < needed ? available : needed;
+                break;
+            }
+
+            shard.appendRange(rest.mid(0, needed));
+            rest = rest.mid(needed);
+
+            shards.append(shard);
+            shard = NetworkPrefixShard();
+            needed = UInt128(static_cast<quint64>(shards.count())) < remainder ? size + 1 : size;
+        }
+    }
+
+    if (!shard.isEmpty()) {
+        shards.append(shard);
     }
+
+    return shards;
 }
 
-NetworkPrefix NetworkPrefixSet::nextPrefix()
+NetworkAddressPermutation NetworkPrefixSet::permutation(quint64 seed) const
 {
-    if (m_currentPrefix < m_prefixSet.size()) {
-        NetworkPrefix returnPrefix = m_prefixSet[m_currentPrefix];
-        ++m_currentPrefix;
-        return returnPrefix;
+    QVector<NetworkAddressRange> ranges;
+    ranges.reserve(d->m_prefixSet.count());
+
+    for (const NetworkPrefix &prefix : d->m_prefixSet) {
+        ranges.append(prefix.toRange());
     }
 
-    return NetworkPrefix();
+    return NetworkAddressPermutation(ranges, seed);
 }
 
-bool NetworkPrefixSet::hasMorePrefixes()
+NetworkPrefixSet NetworkPrefixSet::invert(const NetworkPrefixSet &prefixes)
 {
-    if (m_currentPrefix >= m_prefixSet.count()) {
-        return false;
+    const QVector<NetworkPrefix> sorted = sortedPrefixes(prefixes);
+    QVector<NetworkPrefix> gaps;
+
+    //the IPv4 space is always inverted, as it was before IPv6 support; an
+    //empty or IPv6 only set gives 0.0.0.0/0 for it
+    appendGaps(sorted, NetworkPrefix::fromIpv4(0, 0), gaps);
+    if (!sorted.isEmpty() && sorted.last().isIpv6()) {
+        appendGaps(sorted, NetworkPrefix::fromIpv6(0, 0), gaps);
     }
 
-    return true;
+    return fromVector(gaps);
 }
 
-bool NetworkPrefixSet::hasMoreAddresses()
+NetworkPrefixSet NetworkPrefixSet::invert(const NetworkPrefixSet &prefixes, const NetworkPrefix &within)
 {
-    if (m_currentPrefix >= m_prefixSet.size()) {
-        return false;
-    }
+    QVector<NetworkPrefix> gaps;
 
-    if (m_prefixSet[m_currentPrefix].hasMoreAddresses()) {
-        return true;
+    if (within.isValid()) {
+        appendGaps(sortedPrefixes(prefixes), within, gaps);
     }
 
-    //if the currentPrefix is out of addresses and if any of the next ones still
-    //has some, the we also return true
-    for (int i = m_currentPrefix + 1; i < m_prefixSet.size(); ++i) {
-        if (m_prefixSet[i].addressCount() > 0) {
-            return true;
+    return fromVector(gaps);
+}
+
+NetworkPrefixSet NetworkPrefixSet::aggregate(const NetworkPrefixSet &prefixes,
+                                             QVector<QPair<NetworkPrefix, NetworkPrefix>> *folded)
+{
+    //containing prefixes come right before what they contain, and siblings
+    //end up next to each other
+    const QVector<NetworkPrefix> inputs = sortedPrefixes(prefixes);
+
+    //the stack holds disjoint prefixes in address order; each one keeps the
+    //inputs folded into it as a linked list, so merging two is O(1)
+    struct Entry
+    {
+        NetworkPrefix prefix;
+        int firstInput;
+        int lastInput;
+    };
+
+    QVector<Entry> stack;
+    QVector<int> nextInput(inputs.count(), -1);
+
+    for (int i = 0; i < inputs.count(); ++i) {
+        stack.append({inputs[i], i, i});
+
+        //NetworkPrefix::aggregate() covers both siblings and containment
+        while (stack.count() >= 2) {
+            const Entry &top = stack[stack.count() - 1];
+            const Entry &below = stack[stack.count() - 2];
+            const NetworkPrefix merged = NetworkPrefix::aggregate(below.prefix, top.prefix);
+
+            if (!merged.isValid()) {
+                break;
+            }
+
+            nextInput[below.lastInput] = top.firstInput;
+            const Entry entry = {merged, below.firstInput, top.lastInput};
+            stack.removeLast();
+            stack.last() = entry;
         }
     }
 
-    return false;
-}
+    QVector<NetworkPrefix> outputs;
+    outputs.reserve(stack.count());
 
-NetworkPrefix NetworkPrefixSet::longestPrefixMatch(QHostAddress address)
-{
-    //TODO: test
-    NetworkPrefix returnPrefix;
+    for (const Entry &entry : stack) {
+        outputs.append(entry.prefix);
 
-    for (auto prefix : m_prefixSet) {
-        if (prefix.containsAddress(address)) {
-            if (prefix.prefixLength() > returnPrefix.prefixLength()) {
-                returnPrefix = prefix;
+        if (folded) {
+            for (int input = entry.firstInput; input >= 0; input = nextInput[input]) {
+                folded->append(qMakePair(inputs[input], entry.prefix));
             }
         }
     }
 
-    return returnPrefix;
+    return fromVector(outputs);
 }
 
-bool NetworkPrefixSet::isCoveredBySet(NetworkPrefix prefix)
+NetworkPrefixSet NetworkPrefixSet::unite(const NetworkPrefixSet &a, const NetworkPrefixSet &b)
 {
-    //TODO: test
+    return combine(a, b, [](bool inA, bool inB) { return inA || inB; });
+}
 
-    for (auto prefixFromSet : m_prefixSet) {
-        if (prefixFromSet.containsPrefix(prefix)) {
-            return true;
-        }
-    }
+NetworkPrefixSet NetworkPrefixSet::intersect(const NetworkPrefixSet &a, const NetworkPrefixSet &b)
+{
+    return combine(a, b, [](bool inA, bool inB) { return inA && inB; });
+}
 
-    return false;
+NetworkPrefixSet NetworkPrefixSet::subtract(const NetworkPrefixSet &a, const NetworkPrefixSet &b)
+{
+    return combine(a, b, [](bool inA, bool inB) { return inA && !inB; });
 }
 
-int NetworkPrefixSet::prefixCount()
+NetworkPrefixSet NetworkPrefixSet::symmetricDifference(const NetworkPrefixSet &a, const NetworkPrefixSet &b)
 {
-    return m_prefixSet.count();
+    return combine(a, b, [](bool inA, bool inB) { return inA != inB; });
 }
 
-NetworkPrefixSet NetworkPrefixSet::invert(NetworkPrefixSet prefixes)
+//sorted, disjoint and non-adjacent ranges covering the same addresses as the
+//set, IPv4 first
+QVector<NetworkAddressRange> NetworkPrefixSet::mergedRanges(const NetworkPrefixSet &prefixes)
 {
-    NetworkPrefix startPrefix(QHostAddress("0.0.0.0"), 0);
-    NetworkPrefixSet returnSet;
+    QVector<NetworkAddressRange> ranges;
 
-    findInvertedPrefixes(prefixes, startPrefix, returnSet);
+    for (const NetworkPrefix &prefix : sortedPrefixes(prefixes)) {
+        const NetworkAddressRange range = prefix.toRange();
 
-    return returnSet;
+        if (!ranges.isEmpty() && ranges.last().addressFamily() == range.addressFamily()) {
+            const NetworkAddressRange &last = ranges.last();
+
+            //the sort puts range.rawFirst() at or after last.rawFirst()
+            if (last.rawLast() == UInt128::max() || range.rawFirst() <= last.rawLast() + 1) {
+                if (range.rawLast() > last.rawLast()) {
+                    ranges.last() = makeRange(range.isIpv4(), last.rawFirst(), range.rawLast());
+                }
+                continue;
+            }
+        }
+
+        ranges.append(range);
+    }
+
+    return ranges;
 }
 
-NetworkPrefix NetworkPrefixSet::findInvertedPrefixes(NetworkPrefixSet inputPrefixes,
-                                                     NetworkPrefix currentPrefix,
-                                                     NetworkPrefixSet &outputPrefixes)
+//walks both range lists at once, cutting the address space into segments
+//where membership in a and b does not change, and keeps the segments keep()
+//says yes to; that is O(n + m) segments after sorting
+NetworkPrefixSet NetworkPrefixSet::combine(const NetworkPrefixSet &a,
+                                           const NetworkPrefixSet &b,
+                                           bool (*keep)(bool inA, bool inB))
 {
-    NetworkPrefix left(currentPrefix.address(), currentPrefix.prefixLength() + 1);
-    NetworkPrefix right(QHostAddress(currentPrefix.address().toIPv4Address()
-                                     + static_cast<uint>(
-                                         qFloor(qPow(2, 32 - (currentPrefix.prefixLength() + 1))))),
-                        currentPrefix.prefixLength() + 1);
+    const QVector<NetworkAddressRange> rangesA = mergedRanges(a);
+    const QVector<NetworkAddressRange> rangesB = mergedRanges(b);
+    QVector<NetworkPrefix> prefixes;
+    int i = 0;
+    int j = 0;
+
+    for (const bool ipv4 : {true, false}) {
+        const UInt128 familyLast = ipv4 ? UInt128(0xffffffff) : UInt128::max();
+        QVector<NetworkAddressRange> kept;
+        UInt128 current = 0;
+
+        //where a segment starting at current ends, and whether it is in the list
+        auto segment = [ipv4, &familyLast, &current](const QVector<NetworkAddressRange> &ranges,
+                                                     int &index,
+                                                     UInt128 *segmentLast) {
+            while (index < ranges.count() && ranges[index].isIpv4() == ipv4
+                   && ranges[index].rawLast() < current) {
+                ++index;
+            }
 
-    bool needToGoLeft = false;
-    bool needToGoRight = false;
-    bool leftMatches = false;
-    bool rightMatches = false;
+            if (index == ranges.count() || ranges[index].isIpv4() != ipv4) {
+                *segmentLast = familyLast;
+                return false;
+            }
 
-    //qDebug() << "Left: " << left;
-    //qDebug() << "Right: " << right;
+            if (ranges[index].rawFirst() <= current) {
+                *segmentLast = ranges[index].rawLast();
+                return true;
+            }
 
-    for (NetworkPrefix x : inputPrefixes.m_prefixSet) {
-        if (x == left) {
-            leftMatches = true;
-            continue;
+            *segmentLast = ranges[index].rawFirst() - 1;
+            return false;
+        };
+
+        for (;;) {
+            UInt128 lastA;
+            UInt128 lastB;
+            const bool inA = segment(rangesA, i, &lastA);
+            const bool inB = segment(rangesB, j, &lastB);
+            const UInt128 segmentLast = qMin(lastA, lastB);
+
+            if (keep(inA, inB)) {
+                //neighbouring segments that are both kept form one range
+                if (!kept.isEmpty() && kept.last().rawLast() + 1 == current) {
+                    kept.last() = makeRange(ipv4, kept.last().rawFirst(), segmentLast);
+                } else {
+                    kept.append(makeRange(ipv4, current, segmentLast));
+                }
+            }
+
+            if (segmentLast == familyLast) {
+                break;
+            }
+            current = segmentLast + 1;
         }
 
-        if (left.containsPrefix(x)) {
-            needToGoLeft = true;
-            break;
+        for (const NetworkAddressRange &range : kept) {
+            prefixes += range.toPrefixes();
+        }
+
+        //the IPv6 ranges follow
+        while (i < rangesA.count() && rangesA[i].isIpv4()) {
+            ++i;
+        }
+        while (j < rangesB.count() && rangesB[j].isIpv4()) {
+            ++j;
         }
     }
 
-    if (!leftMatches) {
-        if (needToGoLeft && left.prefixLength() < 32) {
-            //qDebug() << "going left";
-            findInvertedPrefixes(inputPrefixes, left, outputPrefixes);
-        } else {
-            //qDebug() << "Adding: " << left;
-            outputPrefixes.addPrefix(left);
+    return fromVector(prefixes);
+}
+
+//valid prefixes ordered by family, address and length, IPv4 first
+QVector<NetworkPrefix> NetworkPrefixSet::sortedPrefixes(const NetworkPrefixSet &prefixes)
+{
+    QVector<NetworkPrefix> sorted;
+    sorted.reserve(prefixes.d->m_prefixSet.count());
+    for (const NetworkPrefix &prefix : prefixes.d->m_prefixSet) {
+        if (prefix.isValid()) {
+            sorted.append(prefix);
         }
     }
 
-    for (NetworkPrefix x : inputPrefixes.m_prefixSet) {
-        if (x == right) {
-            rightMatches = true;
+    std::sort(sorted.begin(), sorted.end(), [](const NetworkPrefix &a, const NetworkPrefix &b) {
+        if (a.addressFamily() != b.addressFamily()) {
+            return a.addressFamily() < b.addressFamily();
+        }
+        if (a.rawAddress() != b.rawAddress()) {
+            return a.rawAddress() < b.rawAddress();
+        }
+        return a.prefixLength() < b.prefixLength();
+    });
+
+    return sorted;
+}
+
+//sweeps the sorted prefixes once and appends the prefixes covering every gap
+//between them inside of within; overlapping and duplicate prefixes are fine
+void NetworkPrefixSet::appendGaps(const QVector<NetworkPrefix> &sorted,
+                                  const NetworkPrefix &within,
+                                  QVector<NetworkPrefix> &gaps)
+{
+    const NetworkAddressRange bounds = within.toRange();
+    UInt128 next = bounds.rawFirst(); //first address not known to be covered
+
+    auto appendGap = [&bounds, &gaps](const UInt128 &first, const UInt128 &last) {
+        const NetworkAddressRange gap = bounds.isIpv4()
+                                            ? NetworkAddressRange::fromIpv4(static_cast<quint32>(first.lo),
+                                                                            static_cast<quint32>(last.lo))
+                                            : NetworkAddressRange::fromIpv6(first, last);
+        gaps += gap.toPrefixes();
+    };
+
+    for (const NetworkPrefix &prefix : sorted) {
+        if (prefix.addressFamily() != within.addressFamily()) {
             continue;
         }
-        if (right.containsPrefix(x)) {
-            needToGoRight = true;
-            break;
+
+        //prefixes either nest or are disjoint, so anything not inside of
+        //within either covers all of it or nothing
+        if (prefix.containsPrefix(within)) {
+            return;
         }
-    }
-    if (!rightMatches) {
-        if (needToGoRight && right.prefixLength() < 32) {
-            //qDebug() << "going right";
-            findInvertedPrefixes(inputPrefixes, right, outputPrefixes);
-        } else {
-            //qDebug() << "Adding: " << right;
-            outputPrefixes.addPrefix(right);
+        if (!within.containsPrefix(prefix)) {
+            continue;
         }
+
+        const NetworkAddressRange range = prefix.toRange();
+        if (range.rawLast() < next) {
+            continue;
+        }
+
+        if (range.rawFirst() > next) {
+            appendGap(next, range.rawFirst() - 1);
+        }
+
+        if (range.rawLast() == bounds.rawLast()) {
+            return;
+        }
+        next = range.rawLast() + 1;
     }
 
-    return NetworkPrefix();
+    appendGap(next, bounds.rawLast());
 }
 
 void NetworkPrefixSet::clear()
 {
-    m_prefixSet.clear();
-    m_currentPrefix = 0;
+    //other copies keep the old data, there is nothing to copy over
+    d = QSharedDataPointer<NetworkPrefixSetData>(new NetworkPrefixSetData);
 }
 
-void NetworkPrefixSet::resetIterator()
+UInt128 NetworkPrefixSet::addressCount() const
 {
-    m_currentPrefix = 0;
-    for (NetworkPrefix prefix : m_prefixSet) {
-        prefix.resetIterator();
+    UInt128 count = 0;
+
+    for (const NetworkPrefix &prefix : d->m_prefixSet) {
+        const UInt128 prefixCount = prefix.addressCount();
+        count += prefixCount;
+
+        if (count < prefixCount) {
+            return UInt128::max();
+        }
     }
+
+    return count;
 }
 
-quint64 NetworkPrefixSet::addressCount()
+UInt128 NetworkPrefixSet::coveredAddressCount(QAbstractSocket::NetworkLayerProtocol family) const
 {
-    quint64 count = 0;
+    if (!d->m_coverageValid.loadAcquire()) {
+        QMutexLocker locker(&d->m_coverageMutex);
+
+        if (!d->m_coverageValid.loadAcquire()) {
+            UInt128 ipv4 = 0;
+            UInt128 ipv6 = 0;
 
-    for (auto prefix : m_prefixSet) {
-        count += prefix.addressCount();
+            //merged ranges are disjoint, so their sum can only overflow for
+            //::/0, which is a single range and saturates on its own
+            for (const NetworkAddressRange &range : mergedRanges(*this)) {
+                (range.isIpv4() ? ipv4 : ipv6) += range.addressCount();
+            }
+
+            d->m_ipv4Coverage = ipv4;
+            d->m_ipv6Coverage = ipv6;
+            d->m_coverageValid.storeRelease(1);
+        }
     }
 
-    return count;
+    switch (family) {
+    case QAbstractSocket::IPv4Protocol:
+        return d->m_ipv4Coverage;
+    case QAbstractSocket::IPv6Protocol:
+        return d->m_ipv6Coverage;
+    default:
+        return 0;
+    }
+}
+
+void NetworkPrefixSet::indexPrefix(const NetworkPrefix &prefix)
+{
+    d->m_coverageValid.storeRelease(0);
+
+    int &count = d->m_counts[prefix];
+
+    if (count++ == 0) {
+        d->m_trie.insert(prefix, 0);
+    }
+}
+
+void NetworkPrefixSet::unindexPrefix(const NetworkPrefix &prefix)
+{
+    d->m_coverageValid.storeRelease(0);
+
+    const int count = d->m_counts.value(prefix, 0);
+
+    if (count > 1) {
+        d->m_counts.insert(prefix, count - 1);
+    } else if (count == 1) {
+        d->m_counts.remove(prefix);
+        d->m_trie.remove(prefix);
+    }
 }
 
 QDebug operator<<(QDebug dbg, const NetworkPrefixSet &prefixSet)
 {
     dbg.noquote();
 
-    for (NetworkPrefix prefix : prefixSet.toVector()) {
+    for (const NetworkPrefix &prefix : prefixSet.toVector()) {
         dbg << prefix;
     }
 
     return dbg;
 }
+
+QDataStream &operator<<(QDataStream &stream, const NetworkPrefixSet &prefixSet)
+{
+    const QVector<NetworkPrefix> prefixes = prefixSet.toVector();
+    QByteArray block(prefixes.count() * NetworkPrefix::MaxEncodedSize, Qt::Uninitialized);
+    uchar *data = reinterpret_cast<uchar *>(block.data());
+    int size = 0;
+
+    for (const NetworkPrefix &prefix : prefixes) {
+        size += prefix.encode(data + size);
+    }
+
+    stream << static_cast<quint32>(prefixes.count()) << static_cast<quint32>(size);
+    if (stream.writeRawData(block.constData(), size) != size) {
+        stream.setStatus(QDataStream::WriteFailed);
+    }
+
+    return stream;
+}
+
+QDataStream &operator>>(QDataStream &stream, NetworkPrefixSet &prefixSet)
+{
+    quint32 count;
+    quint32 size;
+    prefixSet.clear();
+
+    stream >> count >> size;
+    if (stream.status() != QDataStream::Ok) {
+        return stream;
+    }
+
+    if (quint64(size) < quint64(count) * 2 || quint64(size) > quint64(count) * NetworkPrefix::MaxEncodedSize
+        || size > static_cast<quint32>(std::numeric_limits<int>::max())) {
+        stream.setStatus(QDataStream::ReadCorruptData);
+        return stream;
+    }
+
+    //grow with what actually arrives, a corrupt size must not allocate gigabytes
+    QByteArray block;
+    while (static_cast<quint32>(block.size()) < size) {
+        const int chunk = static_cast<int>(qMin<quint32>(size - static_cast<quint32>(block.size()), 1 << 20));
+        const int offset = block.size();
+        block.resize(offset + chunk);
+
+        if (stream.readRawData(block.data() + offset, chunk) != chunk) {
+            stream.setStatus(QDataStream::ReadPastEnd);
+            return stream;
+        }
+    }
+
+    QVector<NetworkPrefix> prefixes;
+    prefixes.reserve(static_cast<int>(count));
+    const uchar *data = reinterpret_cast<const uchar *>(block.constData());
+    int offset = 0;
+
+    for (quint32 i = 0; i < count; ++i) {
+        int used;
+        prefixes.append(NetworkPrefix::decode(data + offset, block.size() - offset, &used));
+
+        if (used == 0) {
+            stream.setStatus(QDataStream::ReadCorruptData);
+            return stream;
+        }
+        offset += used;
+    }
+
+    if (offset != block.size()) {
+        stream.setStatus(QDataStream::ReadCorruptData);
+        return stream;
+    }
+
+    prefixSet = NetworkPrefixSet::fromVector(std::move(prefixes), true, false);
+    return stream;
+}
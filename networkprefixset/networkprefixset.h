@@ -2,11 +2,28 @@
 #define NETWORKPREFIXSET_H
 
 #include <networkprefix.h>
+#include <networkprefixshard.h>
+#include <networkprefixtrie.h>
 
+#include <QHash>
+#include <QSharedDataPointer>
+
+class NetworkPrefixSetData;
+
+//implicitly shared: copies and pass by value cost one atomic increment, the
+//prefixes are only copied when a shared set is changed
 class NetworkPrefixSet
 {
 public:
     explicit NetworkPrefixSet();
+    NetworkPrefixSet(const NetworkPrefixSet &other);
+    //both moves leave other an empty set, without allocating anything
+    NetworkPrefixSet(NetworkPrefixSet &&other) noexcept;
+    ~NetworkPrefixSet();
+
+    NetworkPrefixSet &operator=(const NetworkPrefixSet &other);
+    NetworkPrefixSet &operator=(NetworkPrefixSet &&other) noexcept;
+    void swap(NetworkPrefixSet &other) noexcept { d.swap(other.d); }
     //    explicit NetworkPrefixSet(QString &fileName,
     //                              bool skipUnparsableLines = false,
     //                              bool allowDuplicates = true,
@@ -17,7 +34,21 @@ public:
                                      bool allowDuplicates = true,
                                      QString startOfComment = "#");
 
-    static NetworkPrefixSet fromVector(QVector<NetworkPrefix> &prefixes,
+    //same as fromFile(), but the file is memory-mapped and parsed on all cores
+    static NetworkPrefixSet fromFileParallel(QString fileName,
+                                             bool skipUnparsableLines = false,
+                                             bool allowDuplicates = true,
+                                             QString startOfComment = "#");
+
+    //the binary format of NetworkPrefixSetFile, which stores every prefix once
+    static NetworkPrefixSet fromBinaryFile(const QString &fileName);
+    bool toBinaryFile(const QString &fileName) const;
+
+    static NetworkPrefixSet fromVector(const QVector<NetworkPrefix> &prefixes,
+                                       bool allowDuplicates = true,
+                                       bool removeNullPrefixes = true);
+    //takes over the vector, which is filtered in place
+    static NetworkPrefixSet fromVector(QVector<NetworkPrefix> &&prefixes,
                                        bool allowDuplicates = true,
                                        bool removeNullPrefixes = true);
 
@@ -25,36 +56,82 @@ public:
 
     void addPrefix(NetworkPrefix prefix, bool allowDuplicates = true);
     void removePrefix(NetworkPrefix prefix, bool removeDuplicates = false);
-    bool contains(NetworkPrefix prefix);
-
-    QHostAddress nextAddress();
-    NetworkPrefix nextPrefix();
-    bool hasMorePrefixes();
-    bool hasMoreAddresses();
+    bool contains(NetworkPrefix prefix) const;
 
-    NetworkPrefix longestPrefixMatch(QHostAddress address);
-    //QVector<QPair<NetworkPrefix, NetworkPrefix>> aggregate(int passes = -1);
-    bool isCoveredBySet(NetworkPrefix prefix);
+    NetworkPrefix longestPrefixMatch(QHostAddress address) const;
+    //batch versions for raw addresses in host byte order, e.g. a few hundred
+    //packets at a time; writes the match or a null prefix for every address
+    void longestPrefixMatches(const quint32 *addresses, int count, NetworkPrefix *matches) const;
+    void longestPrefixMatches(const Q_IPV6ADDR *addresses, int count, NetworkPrefix *matches) const;
+    bool isCoveredBySet(NetworkPrefix prefix) const;
 
     void clear();
-    void resetIterator();
 
-    quint64 addressCount(); //with IPv6 this can be huge, TODO: check and warn, later refactor to __int128
-    int prefixCount();
-
-    static NetworkPrefixSet invert(NetworkPrefixSet prefixes);
+    //the sum over all prefixes, so overlaps and duplicates count repeatedly;
+    //saturates at UInt128::max(), which only ::/0 alone already reaches
+    UInt128 addressCount() const;
+    //the distinct addresses of one family, every address counted once no
+    //matter how many prefixes cover it; ::/0 saturates like above. Sorts the
+    //set on the first call after a change, later calls only read a cache
+    UInt128 coveredAddressCount(QAbstractSocket::NetworkLayerProtocol family) const;
+    int prefixCount() const;
+
+    //at most count shards, balanced by address count, in the same order as a NetworkPrefixSetCursor
+    QVector<NetworkPrefixShard> split(int count) const;
+    //like a NetworkPrefixSetCursor but in a seeded pseudo-random order, duplicate and
+    //overlapping prefixes are visited once per prefix as well
+    NetworkAddressPermutation permutation(quint64 seed) const;
+
+    //the fewest prefixes covering every address not in the set, sorted; the
+    //first version always covers the IPv4 address space and the IPv6 one if
+    //the set has IPv6 prefixes, the second only what is inside of within
+    static NetworkPrefixSet invert(const NetworkPrefixSet &prefixes);
+    static NetworkPrefixSet invert(const NetworkPrefixSet &prefixes, const NetworkPrefix &within);
+
+    //the smallest set of prefixes covering the same addresses, sorted; if
+    //folded is given, it receives every input paired with its covering output
+    static NetworkPrefixSet aggregate(const NetworkPrefixSet &prefixes,
+                                      QVector<QPair<NetworkPrefix, NetworkPrefix>> *folded = nullptr);
+
+    //address set algebra, both families at once; the results are the
+    //fewest prefixes covering the resulting addresses, sorted
+    static NetworkPrefixSet unite(const NetworkPrefixSet &a, const NetworkPrefixSet &b);
+    static NetworkPrefixSet intersect(const NetworkPrefixSet &a, const NetworkPrefixSet &b);
+    static NetworkPrefixSet subtract(const NetworkPrefixSet &a, const NetworkPrefixSet &b);
+    static NetworkPrefixSet symmetricDifference(const NetworkPrefixSet &a, const NetworkPrefixSet &b);
 
 private:
-    QVector<NetworkPrefix> m_prefixSet;
-    int m_currentPrefix;
-
-    static NetworkPrefix findInvertedPrefixes(NetworkPrefixSet inputPrefixes,
-                                              NetworkPrefix currentPrefix,
-                                              NetworkPrefixSet &outputPrefixes);
+    //writes sortedPrefixes(), so files and sets share one order
+    friend class NetworkPrefixSetFile;
+
+    QSharedDataPointer<NetworkPrefixSetData> d;
+
+    void indexPrefix(const NetworkPrefix &prefix);
+    static NetworkPrefixSet fromData(const char *begin,
+                                     const char *end,
+                                     bool parallel,
+                                     bool skipUnparsableLines,
+                                     bool allowDuplicates,
+                                     const QString &startOfComment);
+    void unindexPrefix(const NetworkPrefix &prefix);
+
+    static QVector<NetworkPrefix> sortedPrefixes(const NetworkPrefixSet &prefixes);
+    static QVector<NetworkAddressRange> mergedRanges(const NetworkPrefixSet &prefixes);
+    static NetworkPrefixSet combine(const NetworkPrefixSet &a,
+                                    const NetworkPrefixSet &b,
+                                    bool (*keep)(bool inA, bool inB));
+    static void appendGaps(const QVector<NetworkPrefix> &sorted,
+                           const NetworkPrefix &within,
+                           QVector<NetworkPrefix> &gaps);
 };
 
+Q_DECLARE_SHARED(NetworkPrefixSet)
 Q_DECLARE_METATYPE(NetworkPrefixSet);
 
 QDebug operator<<(QDebug dbg, const NetworkPrefixSet &prefixSet);
+//the count, the size of the block and all prefixes encoded back to back in
+//one block, in the order of toVector()
+QDataStream &operator<<(QDataStream &stream, const NetworkPrefixSet &prefixSet);
+QDataStream &operator>>(QDataStream &stream, NetworkPrefixSet &prefixSet);
 
 #endif // NETWORKPREFIXSET_H
@@ -1,4 +1,4 @@
-QT *= network
+QT *= network concurrent
 
 if(! include($$PWD/../networkprefix/networkprefix.pri) ) {
     message("Unable to load networkprefix.pri")
@@ -7,7 +7,26 @@ if(! include($$PWD/../networkprefix/networkprefix.pri) ) {
 INCLUDEPATH += $$PWD
 
 SOURCES += \
-    $$PWD/networkprefixset.cpp
+    $$PWD/concurrentnetworkprefixset.cpp \
+    $$PWD/networkprefixlookuptable.cpp \
+    $$PWD/networkprefixparser.cpp \
+    $$PWD/networkprefixset.cpp \
+    $$PWD/networkprefixsetcursor.cpp \
+    $$PWD/networkprefixsetexclusioncursor.cpp \
+    $$PWD/networkprefixsetfile.cpp \
+    $$PWD/networkprefixsetunioncursor.cpp \
+    $$PWD/networkprefixshard.cpp \
+    $$PWD/networkprefixtrie.cpp
 
 HEADERS += \
-    $$PWD/networkprefixset.h
+    $$PWD/concurrentnetworkprefixset.h \
+    $$PWD/networkprefixlookuptable.h \
+    $$PWD/networkprefixmap.h \
+    $$PWD/networkprefixparser.h \
+    $$PWD/networkprefixset.h \
+    $$PWD/networkprefixsetcursor.h \
+    $$PWD/networkprefixsetexclusioncursor.h \
+    $$PWD/networkprefixsetfile.h \
+    $$PWD/networkprefixsetunioncursor.h \
+    $$PWD/networkprefixshard.h \
+    $$PWD/networkprefixtrie.h
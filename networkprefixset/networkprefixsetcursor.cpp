@@ -0,0 +1,96 @@
+#include "networkprefixsetcursor.h"
+
+NetworkPrefixSetCursor::NetworkPrefixSetCursor()
+: m_currentPrefix(0)
+{
+}
+
+NetworkPrefixSetCursor::NetworkPrefixSetCursor(const NetworkPrefixSet &prefixSet)
+: m_prefixes(prefixSet.toVector())
+, m_currentPrefix(0)
+{
+    enterPrefix(0);
+}
+
+QHostAddress NetworkPrefixSetCursor::nextAddress()
+{
+    while (m_currentPrefix < m_prefixes.count()) {
+        //invalid prefixes have no addresses, their cursor is used up right away
+        if (m_cursor.hasMoreAddresses()) {
+            return m_cursor.nextAddress();
+        }
+
+        enterPrefix(m_currentPrefix + 1);
+    }
+
+    return QHostAddress();
+}
+
+int NetworkPrefixSetCursor::nextAddresses(quint32 *addresses, int count)
+{
+    return fillAddresses(m_cursor, [this]() { return enterNextPrefix(); }, addresses, count);
+}
+
+int NetworkPrefixSetCursor::nextAddresses(Q_IPV6ADDR *addresses, int count)
+{
+    return fillAddresses(m_cursor, [this]() { return enterNextPrefix(); }, addresses, count);
+}
+
+NetworkPrefix NetworkPrefixSetCursor::nextPrefix()
+{
+    if (m_currentPrefix >= m_prefixes.count()) {
+        return NetworkPrefix();
+    }
+
+    const NetworkPrefix prefix = m_prefixes[m_currentPrefix];
+    enterPrefix(m_currentPrefix + 1);
+    return prefix;
+}
+
+bool NetworkPrefixSetCursor::hasMorePrefixes() const
+{
+    return m_currentPrefix < m_prefixes.count();
+}
+
+bool NetworkPrefixSetCursor::hasMoreAddresses() const
+{
+    if (m_currentPrefix >= m_prefixes.count()) {
+        return false;
+    }
+
+    if (m_cursor.hasMoreAddresses()) {
+        return true;
+    }
+
+    //the current prefix is used up, but any of the next ones may still have some
+    for (int i = m_currentPrefix + 1; i < m_prefixes.count(); ++i) {
+        if (!m_prefixes[i].addressCount().isZero()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void NetworkPrefixSetCursor::resetIterator()
+{
+    enterPrefix(0);
+}
+
+void NetworkPrefixSetCursor::enterPrefix(int index)
+{
+    m_currentPrefix = index;
+    m_cursor = index < m_prefixes.count() ? NetworkAddressCursor(m_prefixes[index])
+                                          : NetworkAddressCursor();
+}
+
+//false once there is no prefix left to enter
+bool NetworkPrefixSetCursor::enterNextPrefix()
+{
+    if (m_currentPrefix >= m_prefixes.count()) {
+        return false;
+    }
+
+    enterPrefix(m_currentPrefix + 1);
+    return m_currentPrefix < m_prefixes.count();
+}
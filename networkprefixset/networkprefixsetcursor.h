@@ -0,0 +1,67 @@
+/**
+ * Walks the prefixes of a NetworkPrefixSet, or all of their addresses, in
+ * the order they were added.
+ *
+ * The set itself has no iteration state, so a const set can be shared by any
+ * number of threads, each walking it with a cursor of its own. A cursor holds
+ * an implicitly shared copy of the prefixes; changing the set afterwards does
+ * not affect a cursor that was created before.
+ *
+ * nextPrefix() and nextAddress() share one position: nextPrefix() moves on to
+ * the next prefix, no matter how many of the addresses of the current one have
+ * been handed out already.
+ */
+
+#ifndef NETWORKPREFIXSETCURSOR_H
+#define NETWORKPREFIXSETCURSOR_H
+
+#include <networkaddresscursor.h>
+#include <networkprefixset.h>
+
+class NetworkPrefixSetCursor
+{
+public:
+    explicit NetworkPrefixSetCursor();
+    explicit NetworkPrefixSetCursor(const NetworkPrefixSet &prefixSet);
+
+    QHostAddress nextAddress();
+    //batch versions of nextAddress(), prefixes of the other family are skipped
+    int nextAddresses(quint32 *addresses, int count);
+    int nextAddresses(Q_IPV6ADDR *addresses, int count);
+    NetworkPrefix nextPrefix();
+    bool hasMorePrefixes() const;
+    bool hasMoreAddresses() const;
+
+    void resetIterator();
+
+private:
+    void enterPrefix(int index);
+    bool enterNextPrefix();
+
+    QVector<NetworkPrefix> m_prefixes;
+    int m_currentPrefix;
+    NetworkAddressCursor m_cursor; //walks m_prefixes[m_currentPrefix]
+};
+
+//the batching loop of the nextAddresses() overloads of all set cursors,
+//which walk their addresses as a series of pieces: cursor walks the current
+//piece, enterNext() moves it to the next one and returns false at the end.
+//A piece that hands out fewer addresses than asked for is either used up or
+//of the other family, so the rest is asked of the pieces after it
+template<typename Address, typename EnterNext>
+int fillAddresses(NetworkAddressCursor &cursor, EnterNext enterNext, Address *addresses, int count)
+{
+    int written = 0;
+
+    while (written < count) {
+        written += cursor.nextAddresses(addresses + written, count - written);
+
+        if (written < count && !enterNext()) {
+            break;
+        }
+    }
+
+    return written;
+}
+
+#endif // NETWORKPREFIXSETCURSOR_H
@@ -0,0 +1,136 @@
+#include "networkprefixsetexclusioncursor.h"
+
+#include <networkprefixsetcursor.h>
+
+#include <algorithm>
+
+NetworkPrefixSetExclusionCursor::NetworkPrefixSetExclusionCursor()
+{
+}
+
+NetworkPrefixSetExclusionCursor::NetworkPrefixSetExclusionCursor(const NetworkPrefixSet &include,
+                                                                 const NetworkPrefixSet &exclude)
+: m_include(include)
+{
+    NetworkPrefixSetUnionCursor excluded(exclude);
+
+    for (NetworkAddressRange range = excluded.nextRange(); range.isValid(); range = excluded.nextRange()) {
+        m_excluded.append(range);
+    }
+
+    skipUsedUpPieces();
+}
+
+QHostAddress NetworkPrefixSetExclusionCursor::nextAddress()
+{
+    const QHostAddress address = m_cursor.nextAddress();
+    skipUsedUpPieces();
+    return address;
+}
+
+int NetworkPrefixSetExclusionCursor::nextAddresses(quint32 *addresses, int count)
+{
+    const int written = fillAddresses(m_cursor, [this]() { return enterNextPiece(); }, addresses, count);
+    skipUsedUpPieces(); //the batch may have used up the last piece exactly
+    return written;
+}
+
+int NetworkPrefixSetExclusionCursor::nextAddresses(Q_IPV6ADDR *addresses, int count)
+{
+    const int written = fillAddresses(m_cursor, [this]() { return enterNextPiece(); }, addresses, count);
+    skipUsedUpPieces();
+    return written;
+}
+
+bool NetworkPrefixSetExclusionCursor::hasMoreAddresses() const
+{
+    return m_cursor.hasMoreAddresses();
+}
+
+NetworkAddressRange NetworkPrefixSetExclusionCursor::nextRange()
+{
+    if (!m_cursor.hasMoreAddresses()) {
+        return NetworkAddressRange();
+    }
+
+    const NetworkAddressRange rest = m_cursor.range().mid(m_cursor.position());
+    m_cursor = NetworkAddressCursor();
+    skipUsedUpPieces();
+    return rest;
+}
+
+void NetworkPrefixSetExclusionCursor::resetIterator()
+{
+    m_include.resetIterator();
+    m_rest = NetworkAddressRange();
+    m_cursor = NetworkAddressCursor();
+    skipUsedUpPieces();
+}
+
+//cuts the next permitted piece off the current include interval, moving on
+//to the next interval when it is used up; false at the end
+bool NetworkPrefixSetExclusionCursor::enterNextPiece()
+{
+    for (;;) {
+        if (!m_rest.isValid()) {
+            m_rest = m_include.nextRange();
+
+            if (!m_rest.isValid()) {
+                m_cursor = NetworkAddressCursor();
+                return false;
+            }
+        }
+
+        const int index = firstExclusionUpTo(m_rest);
+        if (index < 0) {
+            m_cursor = NetworkAddressCursor(m_rest);
+            m_rest = NetworkAddressRange();
+            return true;
+        }
+
+        //everything in front of the exclusion is permitted, everything behind
+        //it is left for the next call
+        const NetworkAddressRange &exclusion = m_excluded[index];
+        const UInt128 first = m_rest.rawFirst();
+        const NetworkAddressRange piece = exclusion.rawFirst() > first
+                                              ? m_rest.mid(0, exclusion.rawFirst() - first)
+                                              : NetworkAddressRange();
+
+        m_rest = exclusion.rawLast() >= m_rest.rawLast() ? NetworkAddressRange()
+                                                         : m_rest.mid(exclusion.rawLast() + 1 - first);
+
+        if (piece.isValid()) {
+            m_cursor = NetworkAddressCursor(piece);
+            return true;
+        }
+    }
+}
+
+void NetworkPrefixSetExclusionCursor::skipUsedUpPieces()
+{
+    //keeps hasMoreAddresses() a plain look at the current piece
+    while (!m_cursor.hasMoreAddresses() && enterNextPiece()) {
+    }
+}
+
+//the index of the first exclusion overlapping range, -1 if none does
+int NetworkPrefixSetExclusionCursor::firstExclusionUpTo(const NetworkAddressRange &range) const
+{
+    //exclusions of one family are disjoint and sorted, so their last
+    //addresses are sorted as well
+    const auto it = std::lower_bound(m_excluded.constBegin(),
+                                     m_excluded.constEnd(),
+                                     range,
+                                     [](const NetworkAddressRange &exclusion, const NetworkAddressRange &range) {
+                                         if (exclusion.isIpv4() != range.isIpv4()) {
+                                             return exclusion.isIpv4();
+                                         }
+                                         return exclusion.rawLast() < range.rawFirst();
+                                     });
+
+    if (it == m_excluded.constEnd() || it->isIpv4() != range.isIpv4() || it->rawFirst() > range.rawLast()) {
+        return -1;
+    }
+
+    return static_cast<int>(it - m_excluded.constBegin());
+}
@@ -0,0 +1,51 @@
+/**
+ * Walks the addresses covered by an include set that are not covered by an
+ * exclude set, in ascending order and each of them once, e.g. 0.0.0.0/0 or a
+ * customer block minus bogons and opt-outs. Both families are supported.
+ *
+ * Neither the difference nor the inverted exclude set is ever built. The
+ * include set is merged lazily by a NetworkPrefixSetUnionCursor. The exclude
+ * set is merged into sorted, disjoint ranges up front, one per interval, so
+ * every excluded interval is jumped over with a binary search instead of
+ * testing addresses one by one.
+ */
+
+#ifndef NETWORKPREFIXSETEXCLUSIONCURSOR_H
+#define NETWORKPREFIXSETEXCLUSIONCURSOR_H
+
+#include <networkaddresscursor.h>
+#include <networkprefixset.h>
+#include <networkprefixsetunioncursor.h>
+
+class NetworkPrefixSetExclusionCursor
+{
+public:
+    explicit NetworkPrefixSetExclusionCursor();
+    explicit NetworkPrefixSetExclusionCursor(const NetworkPrefixSet &include,
+                                             const NetworkPrefixSet &exclude);
+
+    QHostAddress nextAddress();
+    //like NetworkPrefixSetCursor::nextAddresses()
+    int nextAddresses(quint32 *addresses, int count);
+    int nextAddresses(Q_IPV6ADDR *addresses, int count);
+    bool hasMoreAddresses() const;
+
+    //the rest of the current permitted interval, or the next one if it is
+    //used up; an invalid range at the end
+    NetworkAddressRange nextRange();
+
+    void resetIterator();
+
+private:
+    bool enterNextPiece();
+    void skipUsedUpPieces();
+    int firstExclusionUpTo(const NetworkAddressRange &range) const;
+
+    NetworkPrefixSetUnionCursor m_include;
+    QVector<NetworkAddressRange> m_excluded; //merged, IPv4 first, then by address
+    NetworkAddressRange m_rest;              //what is left of the current include interval
+    NetworkAddressCursor m_cursor;           //walks the current permitted piece, only
+                                             //used up if there is nothing left at all
+};
+
+#endif // NETWORKPREFIXSETEXCLUSIONCURSOR_H
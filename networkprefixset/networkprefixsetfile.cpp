@@ -0,0 +1,271 @@
+#include "networkprefixsetfile.h"
+
+#include <prefixmath.h>
+
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <limits>
+
+NetworkPrefixSetFile::NetworkPrefixSetFile()
+: m_data(nullptr)
+, m_ipv4Count(0)
+, m_ipv6Count(0)
+{
+}
+
+NetworkPrefixSetFile::~NetworkPrefixSetFile()
+{
+    close();
+}
+
+bool NetworkPrefixSetFile::save(const NetworkPrefixSet &prefixSet, const QString &fileName)
+{
+    QVector<NetworkPrefix> prefixes = NetworkPrefixSet::sortedPrefixes(prefixSet);
+    prefixes.erase(std::unique(prefixes.begin(), prefixes.end()), prefixes.end());
+
+    const int ipv4Count = static_cast<int>(
+        std::count_if(prefixes.cbegin(), prefixes.cend(), [](const NetworkPrefix &prefix) {
+            return prefix.isIpv4();
+        }));
+    const int ipv6Count = prefixes.count() - ipv4Count;
+
+    const qint64 size = HeaderSize + qint64(ipv4Count) * Ipv4RecordSize + qint64(ipv6Count) * Ipv6RecordSize;
+    if (size > std::numeric_limits<int>::max()) {
+        return false;
+    }
+
+    QByteArray data(static_cast<int>(size), '\0');
+    uchar *header = reinterpret_cast<uchar *>(data.data());
+    qToBigEndian<quint32>(Magic, header);
+    qToBigEndian<quint16>(Version, header + 4);
+    qToBigEndian<quint16>(HeaderSize, header + 6);
+    qToBigEndian<quint32>(static_cast<quint32>(ipv4Count), header + 8);
+    qToBigEndian<quint32>(static_cast<quint32>(ipv6Count), header + 12);
+
+    //the parent of a record is the closest one on the stack that contains it;
+    //the sort order puts every prefix after all of those containing it
+    QVector<int> stack;
+    for (int i = 0; i < prefixes.count(); ++i) {
+        const NetworkPrefix &prefix = prefixes[i];
+        const bool ipv4 = prefix.isIpv4();
+        const int first = ipv4 ? 0 : ipv4Count;
+
+        while (!stack.isEmpty()
+               && (stack.last() < first || !prefixes[stack.last()].containsPrefix(prefix))) {
+            stack.removeLast();
+        }
+
+        const quint32 parent = stack.isEmpty() ? NoParent : static_cast<quint32>(stack.last() - first);
+        stack.append(i);
+
+        uchar *record = header + HeaderSize;
+        if (ipv4) {
+            record += i * Ipv4RecordSize;
+            qToBigEndian<quint32>(static_cast<quint32>(prefix.rawAddress().lo), record);
+            record[4] = static_cast<uchar>(prefix.prefixLength());
+            qToBigEndian<quint32>(parent, record + 8);
+        } else {
+            record += ipv4Count * Ipv4RecordSize + (i - ipv4Count) * Ipv6RecordSize;
+            prefix.rawAddress().toBytes(record);
+            record[16] = static_cast<uchar>(prefix.prefixLength());
+            qToBigEndian<quint32>(parent, record + 20);
+        }
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size()) {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
+
+bool NetworkPrefixSetFile::open(const QString &fileName)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const qint64 size = m_file.size();
+    const uchar *data = size >= HeaderSize ? m_file.map(0, size) : nullptr;
+    if (!data) {
+        m_file.close();
+        return false;
+    }
+
+    const quint32 ipv4Count = qFromBigEndian<quint32>(data + 8);
+    const quint32 ipv6Count = qFromBigEndian<quint32>(data + 12);
+
+    if (qFromBigEndian<quint32>(data) != Magic || qFromBigEndian<quint16>(data + 4) != Version
+        || qFromBigEndian<quint16>(data + 6) != HeaderSize
+        || size != HeaderSize + qint64(ipv4Count) * Ipv4RecordSize + qint64(ipv6Count) * Ipv6RecordSize
+        || qint64(ipv4Count) + ipv6Count > std::numeric_limits<int>::max()) {
+        m_file.close();
+        return false;
+    }
+
+    m_data = data;
+    m_ipv4Count = ipv4Count;
+    m_ipv6Count = ipv6Count;
+
+    return true;
+}
+
+void NetworkPrefixSetFile::close()
+{
+    //closing the file unmaps it as well
+    m_file.close();
+    m_data = nullptr;
+    m_ipv4Count = 0;
+    m_ipv6Count = 0;
+}
+
+bool NetworkPrefixSetFile::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+NetworkPrefix NetworkPrefixSetFile::longestPrefixMatch(QHostAddress address) const
+{
+    const bool ipv4 = address.protocol() == QAbstractSocket::IPv4Protocol;
+    if (!isOpen() || (!ipv4 && address.protocol() != QAbstractSocket::IPv6Protocol)) {
+        return NetworkPrefix();
+    }
+
+    UInt128 raw;
+    if (ipv4) {
+        raw = address.toIPv4Address();
+    } else {
+        const Q_IPV6ADDR bytes = address.toIPv6Address();
+        raw = UInt128::fromBytes(bytes.c);
+    }
+
+    //every prefix containing the address is an ancestor of the last one
+    //starting at or before it, or that one itself
+    for (quint32 index = lastStartingAtOrBefore(ipv4, raw); index != NoParent;
+         index = parentAt(ipv4, index)) {
+        const NetworkPrefix prefix = recordAt(ipv4, index);
+        if (!prefix.isValid()) {
+            continue;
+        }
+
+        const UInt128 netmask = ipv4 ? UInt128(PrefixMath::ipv4Netmask(prefix.prefixLength()))
+                                     : PrefixMath::ipv6Netmask(prefix.prefixLength());
+
+        if ((raw & netmask) == prefix.rawAddress()) {
+            return prefix;
+        }
+    }
+
+    return NetworkPrefix();
+}
+
+bool NetworkPrefixSetFile::contains(const NetworkPrefix &prefix) const
+{
+    if (!isOpen() || !prefix.isValid()) {
+        return false;
+    }
+
+    const bool ipv4 = prefix.isIpv4();
+    for (quint32 index = lastStartingAtOrBefore(ipv4, prefix.rawAddress()); index != NoParent;
+         index = parentAt(ipv4, index)) {
+        const NetworkPrefix record = recordAt(ipv4, index);
+        if (!record.isValid()) {
+            continue;
+        }
+
+        if (record == prefix) {
+            return true;
+        }
+        if (record.prefixLength() < prefix.prefixLength()) {
+            break;
+        }
+    }
+
+    return false;
+}
+
+int NetworkPrefixSetFile::prefixCount() const
+{
+    return static_cast<int>(m_ipv4Count + m_ipv6Count);
+}
+
+NetworkPrefix NetworkPrefixSetFile::prefixAt(int index) const
+{
+    if (index < 0 || index >= prefixCount()) {
+        return NetworkPrefix();
+    }
+
+    const quint32 i = static_cast<quint32>(index);
+    return i < m_ipv4Count ? recordAt(true, i) : recordAt(false, i - m_ipv4Count);
+}
+
+NetworkPrefixSet NetworkPrefixSetFile::toSet() const
+{
+    QVector<NetworkPrefix> prefixes;
+    prefixes.reserve(prefixCount());
+
+    for (int i = 0; i < prefixCount(); ++i) {
+        prefixes.append(prefixAt(i));
+    }
+
+    return NetworkPrefixSet::fromVector(prefixes);
+}
+
+const uchar *NetworkPrefixSetFile::recordData(bool ipv4, quint32 index) const
+{
+    //in 64 bits, the records of a large file span more than 4 GiB
+    if (ipv4) {
+        return m_data + HeaderSize + qint64(index) * Ipv4RecordSize;
+    }
+
+    return m_data + HeaderSize + qint64(m_ipv4Count) * Ipv4RecordSize + qint64(index) * Ipv6RecordSize;
+}
+
+NetworkPrefix NetworkPrefixSetFile::recordAt(bool ipv4, quint32 index) const
+{
+    const uchar *record = recordData(ipv4, index);
+
+    //a length out of range gives a null prefix, which callers skip
+    if (ipv4) {
+        return NetworkPrefix::fromIpv4(qFromBigEndian<quint32>(record), record[4]);
+    }
+
+    return NetworkPrefix::fromIpv6(UInt128::fromBytes(record), record[16]);
+}
+
+quint32 NetworkPrefixSetFile::parentAt(bool ipv4, quint32 index) const
+{
+    const quint32 parent = qFromBigEndian<quint32>(recordData(ipv4, index) + (ipv4 ? 8 : 20));
+
+    //a parent always sorts before its child; anything else is a corrupt file
+    //and ends the walk, so it can neither read past the records nor loop
+    return parent < index ? parent : NoParent;
+}
+
+quint32 NetworkPrefixSetFile::lastStartingAtOrBefore(bool ipv4, const UInt128 &address) const
+{
+    quint32 low = 0;
+    quint32 high = ipv4 ? m_ipv4Count : m_ipv6Count;
+
+    //the first record starting after address, the one before it is the result
+    while (low < high) {
+        const quint32 middle = low + (high - low) / 2;
+        const uchar *record = recordData(ipv4, middle);
+        const UInt128 start = ipv4 ? UInt128(qFromBigEndian<quint32>(record)) : UInt128::fromBytes(record);
+
+        if (start <= address) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low == 0 ? NoParent : low - 1;
+}
@@ -0,0 +1,74 @@
+/**
+ * Read-only NetworkPrefixSet stored in a binary file, used straight from the
+ * memory mapped file without parsing or copying it.
+ *
+ * The file starts with a 32 byte header, followed by the sorted IPv4 records
+ * and then the sorted IPv6 records. Records are fixed-width and ordered by
+ * address, then by prefix length, without duplicates. Every record carries
+ * the index of the longest other prefix containing it, so a longest prefix
+ * match is a binary search plus a walk up those parent links. All integers
+ * are in network byte order.
+ *
+ *   header     magic "NPFX", quint16 version, quint16 header size,
+ *              quint32 IPv4 record count, quint32 IPv6 record count,
+ *              16 reserved bytes
+ *   IPv4       4 address bytes, length, 3 reserved bytes, quint32 parent
+ *   IPv6       16 address bytes, length, 3 reserved bytes, quint32 parent
+ *
+ * Opening a file maps it and checks the header and the size; lookups only
+ * touch the pages they need. A parent index that does not point before its
+ * record is treated as no parent and a record with a length out of range is
+ * skipped, so a corrupt file gives wrong answers at worst.
+ */
+
+#ifndef NETWORKPREFIXSETFILE_H
+#define NETWORKPREFIXSETFILE_H
+
+#include <networkprefixset.h>
+
+#include <QFile>
+
+class NetworkPrefixSetFile
+{
+public:
+    explicit NetworkPrefixSetFile();
+    ~NetworkPrefixSetFile();
+
+    static bool save(const NetworkPrefixSet &prefixSet, const QString &fileName);
+
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const;
+
+    NetworkPrefix longestPrefixMatch(QHostAddress address) const;
+    bool contains(const NetworkPrefix &prefix) const;
+
+    //IPv4 prefixes first, each family sorted
+    int prefixCount() const;
+    NetworkPrefix prefixAt(int index) const;
+    NetworkPrefixSet toSet() const;
+
+private:
+    Q_DISABLE_COPY(NetworkPrefixSetFile)
+
+    static const quint32 Magic = 0x4e504658; //"NPFX"
+    static const quint16 Version = 1;
+    static const int HeaderSize = 32;
+    static const int Ipv4RecordSize = 12;
+    static const int Ipv6RecordSize = 24;
+    static const quint32 NoParent = 0xffffffff;
+
+    const uchar *recordData(bool ipv4, quint32 index) const;
+    NetworkPrefix recordAt(bool ipv4, quint32 index) const;
+    quint32 parentAt(bool ipv4, quint32 index) const;
+    //index of the last record of the family starting at or before address,
+    //NoParent if there is none
+    quint32 lastStartingAtOrBefore(bool ipv4, const UInt128 &address) const;
+
+    QFile m_file;
+    const uchar *m_data;
+    quint32 m_ipv4Count;
+    quint32 m_ipv6Count;
+};
+
+#endif // NETWORKPREFIXSETFILE_H
@@ -0,0 +1,112 @@
+#include "networkprefixsetunioncursor.h"
+
+#include <networkprefixsetcursor.h>
+
+#include <algorithm>
+
+NetworkPrefixSetUnionCursor::NetworkPrefixSetUnionCursor()
+: m_nextRange(0)
+{
+}
+
+NetworkPrefixSetUnionCursor::NetworkPrefixSetUnionCursor(const NetworkPrefixSet &prefixSet)
+: m_nextRange(0)
+{
+    const QVector<NetworkPrefix> prefixes = prefixSet.toVector();
+    m_ranges.reserve(prefixes.count());
+
+    for (const NetworkPrefix &prefix : prefixes) {
+        if (prefix.isValid()) {
+            m_ranges.append(prefix.toRange());
+        }
+    }
+
+    std::sort(m_ranges.begin(),
+              m_ranges.end(),
+              [](const NetworkAddressRange &a, const NetworkAddressRange &b) {
+                  if (a.isIpv4() != b.isIpv4()) {
+                      return a.isIpv4();
+                  }
+                  return a.rawFirst() < b.rawFirst();
+              });
+}
+
+QHostAddress NetworkPrefixSetUnionCursor::nextAddress()
+{
+    while (!m_cursor.hasMoreAddresses()) {
+        if (!enterNextInterval()) {
+            return QHostAddress();
+        }
+    }
+
+    return m_cursor.nextAddress();
+}
+
+int NetworkPrefixSetUnionCursor::nextAddresses(quint32 *addresses, int count)
+{
+    return fillAddresses(m_cursor, [this]() { return enterNextInterval(); }, addresses, count);
+}
+
+int NetworkPrefixSetUnionCursor::nextAddresses(Q_IPV6ADDR *addresses, int count)
+{
+    return fillAddresses(m_cursor, [this]() { return enterNextInterval(); }, addresses, count);
+}
+
+bool NetworkPrefixSetUnionCursor::hasMoreAddresses() const
+{
+    //ranges are never empty, every one left makes for at least one address
+    return m_cursor.hasMoreAddresses() || m_nextRange < m_ranges.count();
+}
+
+NetworkAddressRange NetworkPrefixSetUnionCursor::nextRange()
+{
+    if (!m_cursor.hasMoreAddresses() && !enterNextInterval()) {
+        return NetworkAddressRange();
+    }
+
+    const NetworkAddressRange rest = m_cursor.range().mid(m_cursor.position());
+    m_cursor = NetworkAddressCursor();
+    return rest;
+}
+
+void NetworkPrefixSetUnionCursor::resetIterator()
+{
+    m_nextRange = 0;
+    m_cursor = NetworkAddressCursor();
+}
+
+bool NetworkPrefixSetUnionCursor::enterNextInterval()
+{
+    if (m_nextRange >= m_ranges.count()) {
+        m_cursor = NetworkAddressCursor();
+        return false;
+    }
+
+    //the sort puts everything overlapping or touching the interval right
+    //behind its first range
+    const NetworkAddressRange &first = m_ranges[m_nextRange++];
+    UInt128 last = first.rawLast();
+
+    while (m_nextRange < m_ranges.count()) {
+        const NetworkAddressRange &range = m_ranges[m_nextRange];
+
+        if (range.isIpv4() != first.isIpv4()) {
+            break;
+        }
+        //nothing comes after the end of the IPv6 address space, last + 1 would wrap
+        if (last != UInt128::max() && range.rawFirst() > last + 1) {
+            break;
+        }
+
+        if (range.rawLast() > last) {
+            last = range.rawLast();
+        }
+        ++m_nextRange;
+    }
+
+    const UInt128 start = first.rawFirst();
+    m_cursor = NetworkAddressCursor(
+        first.isIpv4() ? NetworkAddressRange::fromIpv4(static_cast<quint32>(start.lo), static_cast<quint32>(last.lo))
+                       : NetworkAddressRange::fromIpv6(start, last));
+    return true;
+}
@@ -0,0 +1,45 @@
+/**
+ * Walks the addresses covered by a NetworkPrefixSet in ascending order, each
+ * of them exactly once: IPv4 first, then IPv6. Duplicate and overlapping
+ * prefixes, say 10.0.0.0/8 and 10.1.0.0/16, do not hand out anything twice.
+ *
+ * The cursor sorts the prefixes once, as address ranges, and merges
+ * overlapping and adjacent ones only when it gets to them; nothing but the
+ * current interval of the union is ever built. Like NetworkPrefixSetCursor it
+ * holds a copy of its own and can walk a const set shared with other threads.
+ */
+
+#ifndef NETWORKPREFIXSETUNIONCURSOR_H
+#define NETWORKPREFIXSETUNIONCURSOR_H
+
+#include <networkaddresscursor.h>
+#include <networkprefixset.h>
+
+class NetworkPrefixSetUnionCursor
+{
+public:
+    explicit NetworkPrefixSetUnionCursor();
+    explicit NetworkPrefixSetUnionCursor(const NetworkPrefixSet &prefixSet);
+
+    QHostAddress nextAddress();
+    //like NetworkPrefixSetCursor::nextAddresses()
+    int nextAddresses(quint32 *addresses, int count);
+    int nextAddresses(Q_IPV6ADDR *addresses, int count);
+    bool hasMoreAddresses() const;
+
+    //the rest of the current interval of the union, or the next interval if
+    //it is used up; an invalid range at the end. Intervals of one family are
+    //disjoint and never adjacent
+    NetworkAddressRange nextRange();
+
+    void resetIterator();
+
+private:
+    bool enterNextInterval();
+
+    QVector<NetworkAddressRange> m_ranges; //one per valid prefix, IPv4 first, then by first address
+    int m_nextRange;                       //the first range not merged into an interval yet
+    NetworkAddressCursor m_cursor;         //walks the current interval
+};
+
+#endif // NETWORKPREFIXSETUNIONCURSOR_H
@@ -0,0 +1,75 @@
+#include "networkprefixshard.h"
+
+NetworkPrefixShard::NetworkPrefixShard()
+: m_currentRange(0)
+{
+}
+
+void NetworkPrefixShard::appendRange(const NetworkAddressRange &range)
+{
+    if (range.isValid()) {
+        m_ranges.append(range);
+
+        if (m_ranges.count() == 1) {
+            m_cursor = NetworkAddressCursor(range);
+        }
+    }
+}
+
+QVector<NetworkAddressRange> NetworkPrefixShard::ranges() const
+{
+    return m_ranges;
+}
+
+QHostAddress NetworkPrefixShard::nextAddress()
+{
+    while (m_currentRange < m_ranges.count()) {
+        if (m_cursor.hasMoreAddresses()) {
+            return m_cursor.nextAddress();
+        }
+
+        if (++m_currentRange < m_ranges.count()) {
+            m_cursor = NetworkAddressCursor(m_ranges[m_currentRange]);
+        }
+    }
+
+    return QHostAddress();
+}
+
+bool NetworkPrefixShard::hasMoreAddresses() const
+{
+    //ranges are never empty, so only the current one can be used up
+    if (m_currentRange >= m_ranges.count()) {
+        return false;
+    }
+
+    return m_cursor.hasMoreAddresses() || m_currentRange + 1 < m_ranges.count();
+}
+
+void NetworkPrefixShard::resetIterator()
+{
+    m_currentRange = 0;
+    m_cursor = m_ranges.isEmpty() ? NetworkAddressCursor()
+                                  : NetworkAddressCursor(m_ranges.first());
+}
+
+UInt128 NetworkPrefixShard::addressCount() const
+{
+    UInt128 count = 0;
+
+    for (const NetworkAddressRange &range : m_ranges) {
+        const UInt128 rangeCount = range.addressCount();
+        count += rangeCount;
+
+        if (count < rangeCount) {
+            return UInt128::max();
+        }
+    }
+
+    return count;
+}
+
+bool NetworkPrefixShard::isEmpty() const
+{
+    return m_ranges.isEmpty();
+}
@@ -0,0 +1,38 @@
+/**
+ * One slice of a NetworkPrefixSet as returned by NetworkPrefixSet::split().
+ * A shard is a list of address ranges, it may cover the tail of one prefix,
+ * several whole prefixes and the head of the next one. Every shard has its
+ * own iterator and shares nothing with the set or the other shards, so each
+ * worker thread can drain its shard without locking.
+ */
+
+#ifndef NETWORKPREFIXSHARD_H
+#define NETWORKPREFIXSHARD_H
+
+#include <networkaddresscursor.h>
+#include <networkaddressrange.h>
+
+class NetworkPrefixShard
+{
+public:
+    explicit NetworkPrefixShard();
+
+    void appendRange(const NetworkAddressRange &range);
+    QVector<NetworkAddressRange> ranges() const;
+
+    QHostAddress nextAddress();
+    bool hasMoreAddresses() const;
+    void resetIterator();
+
+    UInt128 addressCount() const;
+    bool isEmpty() const;
+
+private:
+    QVector<NetworkAddressRange> m_ranges;
+    int m_currentRange;
+    NetworkAddressCursor m_cursor; //walks m_ranges[m_currentRange]
+};
+
+Q_DECLARE_METATYPE(NetworkPrefixShard);
+
+#endif // NETWORKPREFIXSHARD_H
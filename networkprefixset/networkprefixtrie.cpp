@@ -0,0 +1,468 @@
+#include "networkprefixtrie.h"
+
+#include <prefixmath.h>
+
+//a hint only, the lookups are correct without it
+#if defined(__GNUC__)
+#define NETWORKPREFIXTRIE_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define NETWORKPREFIXTRIE_PREFETCH(address)
+#endif
+
+//qMin() takes it by reference, which needs a definition before C++17
+const int NetworkPrefixTrie::Lanes;
+
+NetworkPrefixTrie::NetworkPrefixTrie()
+: m_count(0)
+{
+    m_roots[Ipv4] = -1;
+    m_roots[Ipv6] = -1;
+}
+
+void NetworkPrefixTrie::insert(const NetworkPrefix &prefix, int value)
+{
+    Q_ASSERT(value >= 0);
+
+    UInt128 key;
+    Family family;
+    if (!prefixKey(prefix, &key, &family)) {
+        return;
+    }
+
+    const int length = prefix.prefixLength();
+    int parent = -1;
+    int side = 0;
+    int current = m_roots[family];
+
+    while (current >= 0) {
+        const UInt128 nodeKey = m_nodes[current].key;
+        const int nodeLength = m_nodes[current].length;
+        const int common = commonPrefixLength(key, nodeKey, qMin(length, nodeLength));
+
+        if (common == nodeLength) {
+            if (nodeLength == length) {
+                //prefix is already in the trie, maybe as internal node
+                if (m_nodes[current].value < 0) {
+                    ++m_count;
+                }
+                m_nodes[current].value = value;
+                return;
+            }
+
+            parent = current;
+            side = key.bit(nodeLength);
+            current = m_nodes[current].children[side];
+            continue;
+        }
+
+        //the new prefix branches off above the current node, so it either
+        //becomes the parent of the current node, or both get a new common parent
+        const int nodeSide = nodeKey.bit(common);
+        int inserted;
+
+        if (common == length) {
+            inserted = allocateNode(key, length, value);
+            m_nodes[inserted].children[nodeSide] = current;
+        } else {
+            const int leaf = allocateNode(key, length, value);
+            inserted = allocateNode(key & mask(common), common, -1);
+            m_nodes[inserted].children[nodeSide] = current;
+            m_nodes[inserted].children[1 - nodeSide] = leaf;
+        }
+
+        link(parent, side, family, inserted);
+        ++m_count;
+        return;
+    }
+
+    link(parent, side, family, allocateNode(key, length, value));
+    ++m_count;
+}
+
+bool NetworkPrefixTrie::remove(const NetworkPrefix &prefix)
+{
+    UInt128 key;
+    Family family;
+    if (!prefixKey(prefix, &key, &family)) {
+        return false;
+    }
+
+    const int length = prefix.prefixLength();
+    int grandParent = -1;
+    int grandParentSide = 0;
+    int parent = -1;
+    int side = 0;
+    int current = m_roots[family];
+
+    while (current >= 0) {
+        const Node &node = m_nodes[current];
+
+        if (node.length > length || commonPrefixLength(key, node.key, node.length) < node.length) {
+            return false;
+        }
+
+        if (node.length == length) {
+            break;
+        }
+
+        grandParent = parent;
+        grandParentSide = side;
+        parent = current;
+        side = key.bit(node.length);
+        current = node.children[side];
+    }
+
+    if (current < 0 || m_nodes[current].value < 0) {
+        return false;
+    }
+
+    m_nodes[current].value = -1;
+    --m_count;
+
+    const int left = m_nodes[current].children[0];
+    const int right = m_nodes[current].children[1];
+
+    //with two children the node stays as internal node
+    if (left >= 0 && right >= 0) {
+        return true;
+    }
+
+    if (left >= 0 || right >= 0) {
+        link(parent, side, family, left >= 0 ? left : right);
+        freeNode(current);
+        return true;
+    }
+
+    link(parent, side, family, -1);
+    freeNode(current);
+
+    //an internal parent without a value is left with a single child and
+    //is not needed anymore
+    if (parent >= 0 && m_nodes[parent].value < 0) {
+        link(grandParent, grandParentSide, family, m_nodes[parent].children[1 - side]);
+        freeNode(parent);
+    }
+
+    return true;
+}
+
+int NetworkPrefixTrie::value(const NetworkPrefix &prefix, int defaultValue) const
+{
+    UInt128 key;
+    Family family;
+    if (!prefixKey(prefix, &key, &family)) {
+        return defaultValue;
+    }
+
+    const int length = prefix.prefixLength();
+    int current = m_roots[family];
+
+    while (current >= 0) {
+        const Node &node = m_nodes[current];
+
+        if (node.length > length || commonPrefixLength(key, node.key, node.length) < node.length) {
+            return defaultValue;
+        }
+
+        if (node.length == length) {
+            return node.value >= 0 ? node.value : defaultValue;
+        }
+
+        current = node.children[key.bit(node.length)];
+    }
+
+    return defaultValue;
+}
+
+int NetworkPrefixTrie::longestPrefixMatch(const QHostAddress &address,
+                                          NetworkPrefix *matchedPrefix) const
+{
+    UInt128 key;
+    Family family;
+    if (!addressKey(address, &key, &family)) {
+        return -1;
+    }
+
+    const int width = family == Ipv4 ? 32 : 128;
+    int best = -1;
+    int current = m_roots[family];
+
+    while (current >= 0) {
+        const Node &node = m_nodes[current];
+
+        if (!((key ^ node.key) & mask(node.length)).isZero()) {
+            break;
+        }
+
+        if (node.value >= 0) {
+            best = current;
+        }
+
+        if (node.length >= width) {
+            break;
+        }
+
+        current = node.children[key.bit(node.length)];
+    }
+
+    if (best < 0) {
+        return -1;
+    }
+
+    if (matchedPrefix) {
+        *matchedPrefix = prefixAt(best, family);
+    }
+
+    return m_nodes[best].value;
+}
+
+void NetworkPrefixTrie::longestPrefixMatches(const quint32 *addresses,
+                                             int count,
+                                             int *values,
+                                             NetworkPrefix *matchedPrefixes) const
+{
+    UInt128 keys[Lanes];
+    int bestNodes[Lanes];
+
+    for (int start = 0; start < count; start += Lanes) {
+        const int lanes = qMin(Lanes, count - start);
+
+        for (int i = 0; i < lanes; ++i) {
+            keys[i] = UInt128(static_cast<quint64>(addresses[start + i]) << 32, 0);
+        }
+
+        lookupLanes(keys, lanes, Ipv4, bestNodes);
+        storeMatches(bestNodes,
+                     lanes,
+                     Ipv4,
+                     values ? values + start : nullptr,
+                     matchedPrefixes ? matchedPrefixes + start : nullptr);
+    }
+}
+
+void NetworkPrefixTrie::longestPrefixMatches(const Q_IPV6ADDR *addresses,
+                                             int count,
+                                             int *values,
+                                             NetworkPrefix *matchedPrefixes) const
+{
+    UInt128 keys[Lanes];
+    int bestNodes[Lanes];
+
+    for (int start = 0; start < count; start += Lanes) {
+        const int lanes = qMin(Lanes, count - start);
+
+        for (int i = 0; i < lanes; ++i) {
+            keys[i] = UInt128::fromBytes(addresses[start + i].c);
+        }
+
+        lookupLanes(keys, lanes, Ipv6, bestNodes);
+        storeMatches(bestNodes,
+                     lanes,
+                     Ipv6,
+                     values ? values + start : nullptr,
+                     matchedPrefixes ? matchedPrefixes + start : nullptr);
+    }
+}
+
+QVector<int> NetworkPrefixTrie::values() const
+{
+    QVector<int> values;
+    values.reserve(m_count);
+
+    //pre-order walk, the stack holds at most one pending sibling per level
+    QVector<int> stack;
+    for (const int root : {m_roots[Ipv6], m_roots[Ipv4]}) {
+        if (root >= 0) {
+            stack.append(root);
+        }
+    }
+
+    while (!stack.isEmpty()) {
+        const Node &node = m_nodes[stack.takeLast()];
+
+        if (node.value >= 0) {
+            values.append(node.value);
+        }
+        if (node.children[1] >= 0) {
+            stack.append(node.children[1]);
+        }
+        if (node.children[0] >= 0) {
+            stack.append(node.children[0]);
+        }
+    }
+
+    return values;
+}
+
+void NetworkPrefixTrie::clear()
+{
+    m_nodes.clear();
+    m_freeNodes.clear();
+    m_roots[Ipv4] = -1;
+    m_roots[Ipv6] = -1;
+    m_count = 0;
+}
+
+int NetworkPrefixTrie::count() const
+{
+    return m_count;
+}
+
+bool NetworkPrefixTrie::isEmpty() const
+{
+    return m_count == 0;
+}
+
+bool NetworkPrefixTrie::prefixKey(const NetworkPrefix &prefix, UInt128 *key, Family *family)
+{
+    if (prefix.isIpv4()) {
+        *key = prefix.rawAddress() << 96;
+        *family = Ipv4;
+        return true;
+    }
+
+    if (prefix.isIpv6()) {
+        *key = prefix.rawAddress();
+        *family = Ipv6;
+        return true;
+    }
+
+    return false;
+}
+
+bool NetworkPrefixTrie::addressKey(const QHostAddress &address, UInt128 *key, Family *family)
+{
+    if (address.protocol() == QAbstractSocket::IPv4Protocol) {
+        *key = UInt128(static_cast<quint64>(address.toIPv4Address()) << 32, 0);
+        *family = Ipv4;
+        return true;
+    }
+
+    if (address.protocol() == QAbstractSocket::IPv6Protocol) {
+        Q_IPV6ADDR bytes = address.toIPv6Address();
+        *key = UInt128::fromBytes(bytes.c);
+        *family = Ipv6;
+        return true;
+    }
+
+    return false;
+}
+
+UInt128 NetworkPrefixTrie::mask(int length)
+{
+    //keys are left-aligned, so the IPv6 masks work for both families
+    return PrefixMath::ipv6Netmask(length);
+}
+
+int NetworkPrefixTrie::commonPrefixLength(const UInt128 &a, const UInt128 &b, int maxLength)
+{
+    return qMin((a ^ b).countLeadingZeroBits(), maxLength);
+}
+
+NetworkPrefix NetworkPrefixTrie::prefixAt(int node, Family family) const
+{
+    const Node &n = m_nodes[node];
+
+    if (family == Ipv4) {
+        return NetworkPrefix::fromIpv4(static_cast<quint32>(n.key.hi >> 32), n.length);
+    }
+
+    return NetworkPrefix::fromIpv6(n.key, n.length);
+}
+
+//the same walk as longestPrefixMatch(), one step per lane and round; the
+//next node of every lane is prefetched while the other lanes take their step
+void NetworkPrefixTrie::lookupLanes(const UInt128 *keys, int lanes, Family family, int *bestNodes) const
+{
+    const int width = family == Ipv4 ? 32 : 128;
+    const Node *nodes = m_nodes.constData();
+    int current[Lanes];
+    bool active = m_roots[family] >= 0 && lanes > 0;
+
+    for (int i = 0; i < lanes; ++i) {
+        current[i] = m_roots[family];
+        bestNodes[i] = -1;
+    }
+
+    while (active) {
+        active = false;
+
+        for (int i = 0; i < lanes; ++i) {
+            if (current[i] < 0) {
+                continue;
+            }
+
+            const Node &node = nodes[current[i]];
+            const UInt128 &key = keys[i];
+
+            if (!((key ^ node.key) & mask(node.length)).isZero()) {
+                current[i] = -1;
+                continue;
+            }
+
+            if (node.value >= 0) {
+                bestNodes[i] = current[i];
+            }
+
+            current[i] = node.length >= width ? -1 : node.children[key.bit(node.length)];
+
+            if (current[i] >= 0) {
+                NETWORKPREFIXTRIE_PREFETCH(nodes + current[i]);
+                active = true;
+            }
+        }
+    }
+}
+
+void NetworkPrefixTrie::storeMatches(const int *bestNodes,
+                                     int lanes,
+                                     Family family,
+                                     int *values,
+                                     NetworkPrefix *matchedPrefixes) const
+{
+    for (int i = 0; i < lanes; ++i) {
+        const int best = bestNodes[i];
+        if (values) {
+            values[i] = best >= 0 ? m_nodes[best].value : -1;
+        }
+        if (matchedPrefixes) {
+            matchedPrefixes[i] = best >= 0 ? prefixAt(best, family) : NetworkPrefix();
+        }
+    }
+}
+
+int NetworkPrefixTrie::allocateNode(const UInt128 &key, int length, int value)
+{
+    Node node;
+    node.key = key;
+    node.length = length;
+    node.value = value;
+    node.children[0] = -1;
+    node.children[1] = -1;
+
+    if (!m_freeNodes.isEmpty()) {
+        const int index = m_freeNodes.takeLast();
+        m_nodes[index] = node;
+        return index;
+    }
+
+    m_nodes.append(node);
+    return m_nodes.count() - 1;
+}
+
+void NetworkPrefixTrie::freeNode(int node)
+{
+    m_nodes[node].value = -1;
+    m_nodes[node].children[0] = -1;
+    m_nodes[node].children[1] = -1;
+    m_freeNodes.append(node);
+}
+
+void NetworkPrefixTrie::link(int parent, int side, Family family, int child)
+{
+    if (parent < 0) {
+        m_roots[family] = child;
+    } else {
+        m_nodes[parent].children[side] = child;
+    }
+}
@@ -0,0 +1,87 @@
+/**
+ * Path-compressed binary (Patricia) trie mapping network prefixes to an int.
+ *
+ * There is one tree per address family. Keys are the prefix bits left-aligned in
+ * a 128-bit integer, so IPv4 and IPv6 share all code, and a lookup visits at most
+ * 33 resp. 129 nodes, no matter how many prefixes are stored. Nodes live in one
+ * vector and point to each other by index, so copying the trie is copying that
+ * vector.
+ */
+
+#ifndef NETWORKPREFIXTRIE_H
+#define NETWORKPREFIXTRIE_H
+
+#include <networkprefix.h>
+#include <uint128.h>
+
+#include <QVector>
+
+class NetworkPrefixTrie
+{
+public:
+    explicit NetworkPrefixTrie();
+
+    //values have to be >= 0, a negative value marks an internal node
+    void insert(const NetworkPrefix &prefix, int value);
+    bool remove(const NetworkPrefix &prefix);
+    int value(const NetworkPrefix &prefix, int defaultValue = -1) const;
+
+    //returns the value of the longest matching prefix or -1 if nothing matches
+    int longestPrefixMatch(const QHostAddress &address, NetworkPrefix *matchedPrefix = nullptr) const;
+    //the same for count raw addresses in host byte order at once, writes the
+    //values and the matched prefixes to those output arrays that are given;
+    //several lookups walk the trie side by side, so their cache misses overlap
+    void longestPrefixMatches(const quint32 *addresses,
+                              int count,
+                              int *values,
+                              NetworkPrefix *matchedPrefixes = nullptr) const;
+    void longestPrefixMatches(const Q_IPV6ADDR *addresses,
+                              int count,
+                              int *values,
+                              NetworkPrefix *matchedPrefixes = nullptr) const;
+
+    //all values in prefix order: IPv4 first, then by address, shorter
+    //prefixes before the longer ones they contain
+    QVector<int> values() const;
+
+    void clear();
+    int count() const;
+    bool isEmpty() const;
+
+private:
+    struct Node
+    {
+        UInt128 key;
+        int length;
+        int value;
+        int children[2];
+    };
+
+    enum Family { Ipv4 = 0, Ipv6 = 1 };
+
+    //lookups interleaved by longestPrefixMatches()
+    static const int Lanes = 16;
+
+    static bool prefixKey(const NetworkPrefix &prefix, UInt128 *key, Family *family);
+    static bool addressKey(const QHostAddress &address, UInt128 *key, Family *family);
+    static UInt128 mask(int length);
+    static int commonPrefixLength(const UInt128 &a, const UInt128 &b, int maxLength);
+
+    NetworkPrefix prefixAt(int node, Family family) const;
+    void lookupLanes(const UInt128 *keys, int lanes, Family family, int *bestNodes) const;
+    void storeMatches(const int *bestNodes,
+                      int lanes,
+                      Family family,
+                      int *values,
+                      NetworkPrefix *matchedPrefixes) const;
+    int allocateNode(const UInt128 &key, int length, int value);
+    void freeNode(int node);
+    void link(int parent, int side, Family family, int child);
+
+    QVector<Node> m_nodes;
+    QVector<int> m_freeNodes;
+    int m_roots[2];
+    int m_count;
+};
+
+#endif // NETWORKPREFIXTRIE_H
@@ -1,6 +1,9 @@
 #include <QtTest>
 
 #include <networkprefix.h>
+#include <prefixmath.h>
+
+#include <type_traits>
 
 class networkprefix : public QObject
 {
@@ -19,7 +22,16 @@ private slots:
     void cleanupTestCase();
     void construction();
     void addressIteration();
+    void batchIteration();
+    void iterators();
+    void splitting();
+    void permutation();
     void prefixArithmetics();
+    void rawAddresses();
+    void hashing();
+    void streaming();
+    void netmasks();
+    void benchmarkTrimming();
 };
 
 networkprefix::networkprefix()
@@ -162,66 +174,70 @@ void networkprefix::addressIteration()
     //iterate through v4 prefixes
     {
         NetworkPrefix prefix("192.168.0.0/16");
+        NetworkAddressCursor cursor(prefix);
         QVERIFY(prefix.addressCount() == 65536);
         int count = 0;
-        while (prefix.hasMoreAddresses()) {
-            QHostAddress address = prefix.nextAddress();
+        while (cursor.hasMoreAddresses()) {
+            QHostAddress address = cursor.nextAddress();
             QVERIFY(!address.isNull());
             ++count;
         }
         QVERIFY(count == 65536);
-        QVERIFY(prefix.nextAddress().isNull());
+        QVERIFY(cursor.nextAddress().isNull());
 
         prefix.setNetworkPrefix("192.168.0.0/30");
+        cursor = NetworkAddressCursor(prefix);
         QVector<QHostAddress> addressList;
         addressList << QHostAddress("192.168.0.0") << QHostAddress("192.168.0.1")
                     << QHostAddress("192.168.0.2") << QHostAddress("192.168.0.3");
 
         count = 0;
         for (int i = 0; i < prefix.addressCount(); ++i) {
-            QVERIFY(prefix.nextAddress() == addressList[i]);
+            QVERIFY(cursor.nextAddress() == addressList[i]);
             ++count;
         }
         QVERIFY(count == 4);
-        QVERIFY(prefix.nextAddress().isNull());
+        QVERIFY(cursor.nextAddress().isNull());
 
         //reset iterator and do it again
-        prefix.resetIterator();
+        cursor.resetIterator();
         count = 0;
         for (int i = 0; i < prefix.addressCount(); ++i) {
-            QVERIFY(prefix.nextAddress() == addressList[i]);
+            QVERIFY(cursor.nextAddress() == addressList[i]);
             ++count;
         }
 
         QVERIFY(count == 4);
-        QVERIFY(prefix.nextAddress().isNull());
+        QVERIFY(cursor.nextAddress().isNull());
 
         //reset iterator and do it again
-        prefix.resetIterator();
+        cursor.resetIterator();
         count = 0;
         for (int i = 0; i < prefix.addressCount(); ++i) {
-            QVERIFY(prefix.nextAddress() == addressList[i]);
+            QVERIFY(cursor.nextAddress() == addressList[i]);
             ++count;
         }
 
         QVERIFY(count == 4);
-        QVERIFY(prefix.nextAddress().isNull());
+        QVERIFY(cursor.nextAddress().isNull());
     }
 
     //iterate through v6 prefixes
     {
         NetworkPrefix prefix("2a03:4567:abcd:83:dead:beef:25d4::/114");
+        NetworkAddressCursor cursor(prefix);
         QVERIFY(prefix.addressCount() == 16384);
         int count = 0;
-        while (prefix.hasMoreAddresses()) {
-            QHostAddress address = prefix.nextAddress();
+        while (cursor.hasMoreAddresses()) {
+            QHostAddress address = cursor.nextAddress();
             QVERIFY(!address.isNull());
             ++count;
         }
         QVERIFY(count == 16384);
-        QVERIFY(prefix.nextAddress().isNull());
+        QVERIFY(cursor.nextAddress().isNull());
 
         prefix.setNetworkPrefix("2a03:4567:abcd:83:dead:beef:25d4::/126");
+        cursor = NetworkAddressCursor(prefix);
         QVector<QHostAddress> addressList;
         addressList << QHostAddress("2a03:4567:abcd:83:dead:beef:25d4::")
                     << QHostAddress("2a03:4567:abcd:83:dead:beef:25d4:1")
@@ -230,12 +246,12 @@ void networkprefix::addressIteration()
 
         count = 0;
         for (int i = 0; i < prefix.addressCount(); ++i) {
-            QHostAddress addr = prefix.nextAddress();
+            QHostAddress addr = cursor.nextAddress();
             QVERIFY(addr == addressList[i]);
             ++count;
         }
         QVERIFY(count == 4);
-        QVERIFY(prefix.nextAddress().isNull());
+        QVERIFY(cursor.nextAddress().isNull());
 
         //see if iterating over char array boundaries works as expected
         addressList.clear();
@@ -245,10 +261,11 @@ void networkprefix::addressIteration()
                     << QHostAddress("2a03:4567:abcd:83:dead:beef:25d5:1");
 
         prefix.setNetworkPrefix("2a03:4567:abcd:83:dead:beef:25d4::/111");
+        cursor = NetworkAddressCursor(prefix);
         QVERIFY(prefix.addressCount() == 131072);
         count = 0;
         for (int i = 0; i < prefix.addressCount(); ++i) {
-            QHostAddress addr = prefix.nextAddress();
+            QHostAddress addr = cursor.nextAddress();
             if (i >= 65534 && i <= 65537) {
                 QVERIFY(addr == addressList[i - 65534]);
             }
@@ -256,16 +273,313 @@ void networkprefix::addressIteration()
         }
 
         QVERIFY(count == 131072);
-        QVERIFY(prefix.nextAddress().isNull());
+        QVERIFY(cursor.nextAddress().isNull());
+    }
+
+    //prefixes shorter than a /64 count and iterate with a carry into the upper half
+    {
+        NetworkPrefix prefix("2a03:4567:abcd::/48");
+        NetworkAddressCursor cursor(prefix);
+        QVERIFY(prefix.addressCount() == UInt128(1) << 80);
+        QVERIFY(prefix.addressCount().toString() == QString("1208925819614629174706176"));
+
+        for (int i = 0; i < 65537; ++i) {
+            cursor.nextAddress();
+        }
+        QVERIFY(cursor.nextAddress() == QHostAddress("2a03:4567:abcd::1:1"));
+
+        prefix.setNetworkPrefix("2a03:4567:abcd:83:ffff:ffff:ffff:ffff/63");
+        cursor = NetworkAddressCursor(prefix);
+        cursor.nextAddress();
+        QVERIFY(cursor.hasMoreAddresses());
+        QVERIFY(prefix.addressCount() == UInt128(2, 0));
     }
 
     //what about null prefixes
     {
         NetworkPrefix nullPrefix;
-        QVERIFY(!nullPrefix.hasMoreAddresses());
-        QVERIFY(nullPrefix.nextAddress().isNull());
+        NetworkAddressCursor cursor(nullPrefix);
+        QVERIFY(!cursor.hasMoreAddresses());
+        QVERIFY(cursor.nextAddress().isNull());
         QVERIFY(nullPrefix.addressCount() == 0);
     }
+
+    //cursors on the same const prefix do not see each other
+    {
+        const NetworkPrefix prefix("10.0.0.0/30");
+        NetworkAddressCursor first(prefix);
+        NetworkAddressCursor second(prefix);
+        first.nextAddress();
+        first.nextAddress();
+        QVERIFY(first.position() == 2);
+        QVERIFY(second.nextAddress() == QHostAddress("10.0.0.0"));
+        QVERIFY(first.nextAddress() == QHostAddress("10.0.0.2"));
+        QVERIFY(NetworkAddressCursor(prefix.toRange()).nextAddress() == QHostAddress("10.0.0.0"));
+    }
+}
+
+void networkprefix::batchIteration()
+{
+    //batches have to yield the same addresses as nextAddress()
+    {
+        NetworkPrefix prefix("192.168.0.0/22");
+        NetworkAddressCursor cursor(prefix);
+        NetworkAddressCursor reference(prefix);
+        QVector<quint32> buffer(300);
+        int total = 0;
+        int written;
+
+        while ((written = cursor.nextAddresses(buffer.data(), buffer.count())) > 0) {
+            for (int i = 0; i < written; ++i) {
+                QVERIFY(QHostAddress(buffer[i]) == reference.nextAddress());
+            }
+            total += written;
+        }
+
+        QVERIFY(total == 1024);
+        QVERIFY(!cursor.hasMoreAddresses());
+        QVERIFY(cursor.nextAddress().isNull());
+    }
+
+    {
+        NetworkPrefix prefix("2a03:4567:abcd:83:dead:beef:25d4:fff0/108");
+        NetworkAddressCursor cursor(prefix);
+        cursor.nextAddress();
+        Q_IPV6ADDR buffer[32];
+
+        QVERIFY(cursor.nextAddresses(buffer, 32) == 32);
+        QVERIFY(QHostAddress(buffer[0]) == QHostAddress("2a03:4567:abcd:83:dead:beef:25d0:1"));
+        QVERIFY(QHostAddress(buffer[31]) == QHostAddress("2a03:4567:abcd:83:dead:beef:25d0:20"));
+        QVERIFY(cursor.nextAddress() == QHostAddress("2a03:4567:abcd:83:dead:beef:25d0:21"));
+    }
+
+    //wrong family or nothing left
+    {
+        NetworkPrefix prefix("10.0.0.0/31");
+        NetworkAddressCursor cursor(prefix);
+        Q_IPV6ADDR ipv6Buffer[4];
+        quint32 ipv4Buffer[4];
+
+        QVERIFY(cursor.nextAddresses(ipv6Buffer, 4) == 0);
+        QVERIFY(cursor.nextAddresses(ipv4Buffer, 4) == 2);
+        QVERIFY(ipv4Buffer[1] == 0x0a000001);
+        QVERIFY(cursor.nextAddresses(ipv4Buffer, 4) == 0);
+        QVERIFY(NetworkAddressCursor(NetworkPrefix()).nextAddresses(ipv4Buffer, 4) == 0);
+    }
+}
+
+void networkprefix::iterators()
+{
+    {
+        const NetworkPrefix prefix("192.168.0.0/30");
+        QVector<QHostAddress> addressList;
+        for (const QHostAddress &address : prefix) {
+            addressList << address;
+        }
+
+        QVERIFY(addressList.count() == 4);
+        QVERIFY(addressList.first() == QHostAddress("192.168.0.0"));
+        QVERIFY(addressList.last() == QHostAddress("192.168.0.3"));
+        QVERIFY(std::distance(prefix.begin(), prefix.end()) == 4);
+        QVERIFY((std::is_same<std::iterator_traits<NetworkPrefix::const_iterator>::iterator_category,
+                              std::random_access_iterator_tag>::value));
+        QVERIFY(*(prefix.end() - 1) == QHostAddress("192.168.0.3"));
+        QVERIFY(prefix.begin()[2] == QHostAddress("192.168.0.2"));
+        QVERIFY(prefix.addressAt(4).isNull());
+    }
+
+    //jumps are O(1) and independent of any cursor
+    {
+        NetworkPrefix prefix("2a03:4567:abcd::/48");
+        NetworkPrefix::const_iterator it = prefix.begin() + 65537;
+        QVERIFY(*it == QHostAddress("2a03:4567:abcd::1:1"));
+        QVERIFY(it - prefix.begin() == 65537);
+        it -= 2;
+        QVERIFY(*it == QHostAddress("2a03:4567:abcd::ffff"));
+        QVERIFY(prefix.begin() < it && it < prefix.end());
+        QVERIFY(NetworkAddressCursor(prefix).nextAddress() == QHostAddress("2a03:4567:abcd::"));
+
+        prefix.setNetworkPrefix("2a03::/96");
+        QVERIFY(prefix.end() - prefix.begin() == Q_INT64_C(4294967296));
+
+        //the standard helpers jump as well, a walk would never finish
+        prefix.setNetworkPrefix("2a03::/66");
+        QVERIFY(std::distance(prefix.begin(), prefix.end()) == Q_INT64_C(4611686018427387904));
+        NetworkPrefix::const_iterator last = prefix.begin();
+        std::advance(last, Q_INT64_C(4611686018427387903));
+        QVERIFY(*last == QHostAddress("2a03::3fff:ffff:ffff:ffff"));
+    }
+
+    //several consumers on the same prefix
+    {
+        const NetworkPrefix prefix("10.0.0.0/24");
+        const qint64 matches = std::count_if(prefix.begin(),
+                                             prefix.end(),
+                                             [&prefix](const QHostAddress &address) {
+                                                 return std::find(prefix.begin(), prefix.end(), address)
+                                                        != prefix.end();
+                                             });
+        QVERIFY(matches == 256);
+        QVERIFY(std::lower_bound(prefix.begin(), prefix.end(), QHostAddress("10.0.0.77"),
+                                 [](const QHostAddress &a, const QHostAddress &b) {
+                                     return a.toIPv4Address() < b.toIPv4Address();
+                                 }).index() == 77);
+    }
+
+    {
+        const NetworkPrefix nullPrefix;
+        QVERIFY(nullPrefix.begin() == nullPrefix.end());
+    }
+}
+
+void networkprefix::splitting()
+{
+    //shards are contiguous, disjoint and differ by at most one address
+    {
+        NetworkPrefix prefix("10.0.0.0/8");
+        QVector<NetworkAddressRange> shards = prefix.split(7);
+        QVERIFY(shards.count() == 7);
+        QVERIFY(shards.first().first() == QHostAddress("10.0.0.0"));
+        QVERIFY(shards.last().last() == QHostAddress("10.255.255.255"));
+
+        UInt128 total = 0;
+        for (int i = 0; i < shards.count(); ++i) {
+            QVERIFY(shards[i].isIpv4());
+            QVERIFY(shards[i].addressCount() == 2396745 || shards[i].addressCount() == 2396746);
+            if (i > 0) {
+                QVERIFY(shards[i].rawFirst() == shards[i - 1].rawLast() + 1);
+            }
+            total += shards[i].addressCount();
+        }
+        QVERIFY(total == prefix.addressCount());
+    }
+
+    //every shard iterates on its own
+    {
+        QVector<NetworkAddressRange> shards = NetworkPrefix("192.168.0.0/30").split(3);
+        QVERIFY(shards.count() == 3);
+        NetworkAddressCursor first(shards[0]);
+        NetworkAddressCursor last(shards[2]);
+        QVERIFY(first.nextAddress() == QHostAddress("192.168.0.0"));
+        QVERIFY(first.nextAddress() == QHostAddress("192.168.0.1"));
+        QVERIFY(!first.hasMoreAddresses());
+        QVERIFY(last.nextAddress() == QHostAddress("192.168.0.3"));
+        QVERIFY(last.nextAddress().isNull());
+        QVERIFY(shards[1].addressAt(0) == QHostAddress("192.168.0.2"));
+
+        QVERIFY(NetworkPrefix("192.168.0.0/31").split(5).count() == 2);
+        QVERIFY(NetworkPrefix("192.168.0.0/31").split(0).isEmpty());
+        QVERIFY(NetworkPrefix().split(4).isEmpty());
+    }
+
+    //even the whole IPv6 space ends on the last address
+    {
+        QVector<NetworkAddressRange> shards = NetworkPrefix("::/0").split(4);
+        QVERIFY(shards.count() == 4);
+        QVERIFY(shards[1].rawFirst() == UInt128(Q_UINT64_C(0x4000000000000000), 0));
+        QVERIFY(shards[3].rawLast() == UInt128::max());
+        QVERIFY(shards[3].containsAddress(QHostAddress("ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff")));
+    }
+
+    {
+        NetworkAddressRange range(QHostAddress("10.0.0.5"), QHostAddress("10.0.0.9"));
+        QVERIFY(range.addressCount() == 5);
+        QVERIFY(range.mid(3) == NetworkAddressRange(QHostAddress("10.0.0.8"), QHostAddress("10.0.0.9")));
+        QVERIFY(!range.mid(5).isValid());
+        QVERIFY(NetworkPrefix("::/0").toRange().mid(0).rawLast() == UInt128::max());
+        QVERIFY(!NetworkAddressRange(QHostAddress("10.0.0.9"), QHostAddress("10.0.0.5")).isValid());
+        QVERIFY(!NetworkAddressRange(QHostAddress("10.0.0.9"), QHostAddress("::1")).isValid());
+    }
+
+    //ranges back to prefixes
+    {
+        NetworkAddressRange range(QHostAddress("10.0.0.5"), QHostAddress("10.0.0.20"));
+        const QVector<NetworkPrefix> expected = {NetworkPrefix("10.0.0.5/32"),
+                                                 NetworkPrefix("10.0.0.6/31"),
+                                                 NetworkPrefix("10.0.0.8/29"),
+                                                 NetworkPrefix("10.0.0.16/30"),
+                                                 NetworkPrefix("10.0.0.20/32")};
+        QVERIFY(range.toPrefixes() == expected);
+
+        QVERIFY(NetworkPrefix("0.0.0.0/0").toRange().toPrefixes()
+                == QVector<NetworkPrefix>{NetworkPrefix("0.0.0.0/0")});
+        QVERIFY(NetworkPrefix("::/0").toRange().toPrefixes()
+                == QVector<NetworkPrefix>{NetworkPrefix("::/0")});
+        QVERIFY(NetworkAddressRange(QHostAddress("::1"), QHostAddress("ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff"))
+                    .toPrefixes()
+                    .count()
+                == 128);
+        QVERIFY(NetworkAddressRange().toPrefixes().isEmpty());
+    }
+}
+
+void networkprefix::permutation()
+{
+    //every address exactly once, and not in sequential order
+    {
+        NetworkPrefix prefix("10.1.0.0/16");
+        NetworkAddressPermutation permutation = prefix.permutation(42);
+        QVERIFY(permutation.addressCount() == 65536);
+
+        QVector<bool> seen(65536, false);
+        int inOrder = 0;
+        int count = 0;
+        while (permutation.hasMoreAddresses()) {
+            const QHostAddress address = permutation.nextAddress();
+            QVERIFY(prefix.containsAddress(address));
+            const int index = static_cast<int>(address.toIPv4Address() & 0xffff);
+            QVERIFY(!seen[index]);
+            seen[index] = true;
+            inOrder += index == count ? 1 : 0;
+            ++count;
+        }
+        QVERIFY(count == 65536);
+        QVERIFY(inOrder < 100);
+        QVERIFY(permutation.nextAddress().isNull());
+
+        //the seed decides the order
+        permutation.resetIterator();
+        NetworkAddressPermutation sameSeed = prefix.permutation(42);
+        NetworkAddressPermutation otherSeed = prefix.permutation(43);
+        int differences = 0;
+        for (int i = 0; i < 100; ++i) {
+            const QHostAddress address = permutation.nextAddress();
+            QVERIFY(address == sameSeed.nextAddress());
+            differences += address != otherSeed.nextAddress() ? 1 : 0;
+        }
+        QVERIFY(differences > 90);
+    }
+
+    //slices of the permuted order cover the prefix without overlap
+    {
+        NetworkPrefix prefix("2001:db8::/117");
+        NetworkAddressPermutation permutation = prefix.permutation(7);
+        QVector<NetworkAddressPermutation> slices = permutation.split(3);
+        QVERIFY(slices.count() == 3);
+
+        QVector<bool> seen(2048, false);
+        UInt128 position = 0;
+        for (NetworkAddressPermutation &slice : slices) {
+            while (slice.hasMoreAddresses()) {
+                const QHostAddress address = slice.nextAddress();
+                QVERIFY(address == permutation.addressAt(position));
+                const int index = address.toIPv6Address()[15] | ((address.toIPv6Address()[14] & 7) << 8);
+                QVERIFY(!seen[index]);
+                seen[index] = true;
+                ++position;
+            }
+        }
+        QVERIFY(position == 2048);
+    }
+
+    //tiny and empty ones
+    {
+        NetworkAddressPermutation single = NetworkPrefix("10.0.0.1/32").permutation(1);
+        QVERIFY(single.nextAddress() == QHostAddress("10.0.0.1"));
+        QVERIFY(!single.hasMoreAddresses());
+        QVERIFY(!NetworkPrefix().permutation(1).hasMoreAddresses());
+        QVERIFY(NetworkPrefix("::/0").permutation(1).permute(12345) < UInt128::max());
+    }
 }
 
 void networkprefix::prefixArithmetics()
@@ -401,16 +715,190 @@ void networkprefix::prefixArithmetics()
     }
 }
 
+void networkprefix::rawAddresses()
+{
+    //v4 addresses live in the low 32 bits
+    {
+        NetworkPrefix prefix = NetworkPrefix::fromIpv4(0xc0a81801, 20);
+        validPrefixTest(prefix, QHostAddress("192.168.16.0"), 20);
+        QVERIFY(prefix == NetworkPrefix("192.168.24.0/20"));
+        QVERIFY(prefix.rawAddress() == UInt128(0xc0a81000));
+        QVERIFY(NetworkPrefix::fromIpv4(0xc0a81801, 33) == NetworkPrefix());
+        QVERIFY(NetworkPrefix::fromIpv4(0xc0a81801, -1) == NetworkPrefix());
+        QVERIFY(NetworkPrefix::fromIpv4(0xffffffff, 0) == NetworkPrefix("0.0.0.0/0"));
+    }
+
+    {
+        UInt128 address(0x2a03288000000000, 0x1234);
+        NetworkPrefix prefix = NetworkPrefix::fromIpv6(address, 112);
+        validPrefixTest(prefix, QHostAddress("2a03:2880::"), 112);
+        QVERIFY(prefix == NetworkPrefix("2a03:2880::1234/112"));
+        QVERIFY(prefix.rawAddress() == UInt128(0x2a03288000000000, 0));
+        QVERIFY(NetworkPrefix::fromIpv6(address, 128).address() == QHostAddress("2a03:2880::1234"));
+        QVERIFY(NetworkPrefix::fromIpv6(address, 129) == NetworkPrefix());
+    }
+
+    //same raw value in different families are different prefixes
+    {
+        QVERIFY(!(NetworkPrefix::fromIpv4(0, 0) == NetworkPrefix::fromIpv6(UInt128(), 0)));
+        QVERIFY(!NetworkPrefix("::/0").containsAddress(QHostAddress("1.2.3.4")));
+        QVERIFY(!NetworkPrefix("0.0.0.0/0").containsPrefix(NetworkPrefix("::1")));
+    }
+
+    {
+        QVector<NetworkPrefix> prefixes(1000);
+        for (const NetworkPrefix &prefix : prefixes) {
+            QVERIFY(prefix == NetworkPrefix());
+        }
+    }
+}
+
+void networkprefix::hashing()
+{
+    //equal prefixes hash equal, no matter how they were written
+    QVERIFY(qHash(NetworkPrefix("192.168.11.0/23")) == qHash(NetworkPrefix("192.168.10.0/23")));
+    QVERIFY(qHash(NetworkPrefix("2001:db8::1/32"), 7) == qHash(NetworkPrefix("2001:db8::/32"), 7));
+    QVERIFY(std::hash<NetworkPrefix>()(NetworkPrefix("10.0.0.0/8"))
+            == std::hash<NetworkPrefix>()(NetworkPrefix("10.1.0.0/8")));
+
+    QSet<NetworkPrefix> prefixes;
+    for (int i = 0; i < 4096; ++i) {
+        prefixes.insert(NetworkPrefix::fromIpv4(0x0a000000 + (static_cast<quint32>(i) << 8), 24));
+        prefixes.insert(NetworkPrefix::fromIpv4(0x0a000000 + (static_cast<quint32>(i) << 8), 24));
+    }
+    QVERIFY(prefixes.count() == 4096);
+
+    //same bits, different family or length
+    prefixes.clear();
+    prefixes.insert(NetworkPrefix("0.0.0.0/0"));
+    prefixes.insert(NetworkPrefix("::/0"));
+    prefixes.insert(NetworkPrefix("0.0.0.0/8"));
+    prefixes.insert(NetworkPrefix());
+    QVERIFY(prefixes.count() == 4);
+}
+
+void networkprefix::streaming()
+{
+    const QVector<NetworkPrefix> prefixes = {NetworkPrefix("10.1.2.0/24"),
+                                             NetworkPrefix("0.0.0.0/0"),
+                                             NetworkPrefix("2001:db8::/32"),
+                                             NetworkPrefix("::1/128"),
+                                             NetworkPrefix()};
+
+    QByteArray data;
+    {
+        QDataStream stream(&data, QIODevice::WriteOnly);
+        for (const NetworkPrefix &prefix : prefixes) {
+            stream << prefix;
+        }
+    }
+    QVERIFY(data.size() == 6 + 6 + 18 + 18 + 2);
+    QVERIFY(data.left(6) == QByteArray("\x04\x18\x0a\x01\x02\x00", 6));
+
+    {
+        QDataStream stream(data);
+        for (const NetworkPrefix &expected : prefixes) {
+            NetworkPrefix prefix;
+            stream >> prefix;
+            QVERIFY(prefix == expected);
+        }
+        QVERIFY(stream.status() == QDataStream::Ok);
+        QVERIFY(stream.atEnd());
+    }
+
+    //truncated and corrupt input
+    {
+        NetworkPrefix prefix;
+        QDataStream truncated(data.left(4));
+        truncated >> prefix;
+        QVERIFY(truncated.status() == QDataStream::ReadPastEnd);
+        QVERIFY(!prefix.isValid());
+
+        QDataStream corrupt(QByteArray("\x04\x21\x0a\x01\x02\x00", 6));
+        corrupt >> prefix;
+        QVERIFY(corrupt.status() == QDataStream::ReadCorruptData);
+        QVERIFY(!prefix.isValid());
+    }
+}
+
+void networkprefix::netmasks()
+{
+    //all of this has to work at compile time
+    static_assert(PrefixMath::ipv4Netmask(0) == 0, "");
+    static_assert(PrefixMath::ipv4Netmask(1) == 0x80000000, "");
+    static_assert(PrefixMath::ipv4Netmask(24) == 0xffffff00, "");
+    static_assert(PrefixMath::ipv4Netmask(32) == 0xffffffff, "");
+    static_assert(PrefixMath::ipv4Hostmask(0) == 0xffffffff, "");
+    static_assert(PrefixMath::ipv4AddressCount(0) == Q_UINT64_C(0x100000000), "");
+    static_assert(PrefixMath::ipv4AddressCount(32) == 1, "");
+    static_assert(PrefixMath::ipv6Netmask(0) == UInt128(), "");
+    static_assert(PrefixMath::ipv6Netmask(64) == UInt128(~quint64(0), 0), "");
+    static_assert(PrefixMath::ipv6Netmask(65) == UInt128(~quint64(0), Q_UINT64_C(1) << 63), "");
+    static_assert(PrefixMath::ipv6Netmask(128) == UInt128::max(), "");
+    static_assert(PrefixMath::ipv6AddressCount(128) == 1, "");
+    static_assert(PrefixMath::ipv6AddressCount(64) == UInt128(1, 0), "");
+    static_assert(PrefixMath::ipv6AddressCount(0) == UInt128::max(), "");
+
+    for (int length = 0; length <= 32; ++length) {
+        quint64 count = 1;
+        for (int i = length; i < 32; ++i) {
+            count *= 2;
+        }
+        QVERIFY(PrefixMath::ipv4AddressCount(length) == count);
+        QVERIFY((PrefixMath::ipv4Netmask(length) ^ PrefixMath::ipv4Hostmask(length)) == 0xffffffff);
+    }
+
+    for (int length = 1; length <= 128; ++length) {
+        QVERIFY(PrefixMath::ipv6Netmask(length).bit(length - 1));
+        QVERIFY(length == 128 || !PrefixMath::ipv6Netmask(length).bit(length));
+        QVERIFY(PrefixMath::ipv6AddressCount(length) == UInt128(1) << (128 - length));
+    }
+
+    //the edges have to work on actual prefixes, too
+    QVERIFY(NetworkPrefix("0.0.0.0/0").containsAddress(QHostAddress("255.255.255.255")));
+    QVERIFY(NetworkPrefix("::/0").containsAddress(QHostAddress("ffff::ffff")));
+    QVERIFY(NetworkPrefix("255.255.255.255/0") == NetworkPrefix("0.0.0.0/0"));
+    QVERIFY(NetworkPrefix("10.11.12.13/32").containsAddress(QHostAddress("10.11.12.13")));
+    QVERIFY(!NetworkPrefix("10.11.12.13/32").containsAddress(QHostAddress("10.11.12.12")));
+    QVERIFY(NetworkPrefix("::/0").addressCount() == UInt128::max());
+
+    //the counter arithmetics the iteration relies on
+    QVERIFY(UInt128(0, ~quint64(0)) + 1 == UInt128(1, 0));
+    QVERIFY(UInt128(1, 0) - 1 == UInt128(0, ~quint64(0)));
+    QVERIFY((UInt128(1) << 100) / (UInt128(1) << 36) == UInt128(1) << 64);
+    QVERIFY(UInt128(Q_UINT64_C(0x100000000), 3) * 5 == UInt128(Q_UINT64_C(0x500000000), 15));
+    QVERIFY(UInt128::max().toString() == QString("340282366920938463463374607431768211455"));
+    QVERIFY(UInt128().toString() == QString("0"));
+}
+
+void networkprefix::benchmarkTrimming()
+{
+    QVector<QHostAddress> addresses;
+    for (quint32 i = 0; i < 1024; ++i) {
+        addresses << QHostAddress(i * 2654435761u);
+    }
+
+    int valid = 0;
+    QBENCHMARK {
+        for (int i = 0; i < addresses.count(); ++i) {
+            NetworkPrefix prefix(addresses[i], i % 33);
+            valid += prefix.isValid() ? 1 : 0;
+        }
+    }
+
+    QVERIFY(valid > 0);
+}
+
 void networkprefix::nullPrefixTest(NetworkPrefix prefix)
 {
     QVERIFY(!prefix.isValid());
     QVERIFY(prefix.prefixLength() == -1);
     QVERIFY(prefix.address().isNull());
-    QVERIFY(prefix.nextAddress().isNull());
+    QVERIFY(NetworkAddressCursor(prefix).nextAddress().isNull());
     QVERIFY(!prefix.isIpv4());
     QVERIFY(!prefix.isIpv6());
     QVERIFY(prefix.addressCount() == 0);
-    QVERIFY(!prefix.hasMoreAddresses());
+    QVERIFY(!NetworkAddressCursor(prefix).hasMoreAddresses());
     QVERIFY(prefix.addressFamily() == QAbstractSocket::UnknownNetworkLayerProtocol);
 }
 
@@ -426,24 +914,25 @@ void networkprefix::validPrefixTest(NetworkPrefix prefix,
     QVERIFY(prefix.isIpv4() || prefix.isIpv6());
     QVERIFY(!prefix.address().isNull());
     //even a host address should at the beginning have a single address
-    QHostAddress tmp = prefix.nextAddress();
+    NetworkAddressCursor cursor(prefix);
+    QHostAddress tmp = cursor.nextAddress();
     QVERIFY(tmp == prefix.address());
 
     //get one more in case there is one
     if ((prefix.isIpv4() && prefix.prefixLength() < 32)
         || (prefix.isIpv6() && prefix.prefixLength() < 128)) {
-        QVERIFY(prefix.hasMoreAddresses());
-        QHostAddress addr = prefix.nextAddress();
+        QVERIFY(cursor.hasMoreAddresses());
+        QHostAddress addr = cursor.nextAddress();
         QVERIFY(!addr.isNull() && addr != prefix.address());
     } else {
-        QVERIFY(!prefix.hasMoreAddresses());
-        QVERIFY(prefix.nextAddress().isNull());
+        QVERIFY(!cursor.hasMoreAddresses());
+        QVERIFY(cursor.nextAddress().isNull());
     }
 
     if (prefix.isIpv4()) {
-        QVERIFY(prefix.addressCount() == static_cast<quint64>(qPow(2, 32 - expectedLength)));
-    } else {
-        QVERIFY(prefix.addressCount() == static_cast<quint64>(qPow(2, 128 - expectedLength)));
+        QVERIFY(prefix.addressCount() == UInt128(1) << (32 - expectedLength));
+    } else if (expectedLength > 0) {
+        QVERIFY(prefix.addressCount() == UInt128(1) << (128 - expectedLength));
     }
 
     //after all this address mangling, is the address still correct
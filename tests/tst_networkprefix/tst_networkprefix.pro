@@ -1,7 +1,7 @@
 QT += testlib network
 QT -= gui
 
-CONFIG += qt console warn_on depend_includepath testcase
+CONFIG += qt console warn_on depend_includepath testcase c++14
 CONFIG -= app_bundle
 
 TEMPLATE = app
@@ -1,8 +1,17 @@
 #include <QtTest>
 
+#include <concurrentnetworkprefixset.h>
+#include <networkprefixlookuptable.h>
+#include <networkprefixmap.h>
+#include <networkprefixparser.h>
 #include <networkprefixset.h>
+#include <networkprefixsetcursor.h>
+#include <networkprefixsetexclusioncursor.h>
+#include <networkprefixsetfile.h>
+#include <networkprefixsetunioncursor.h>
 #include <QFile>
 #include <QTextStream>
+#include <QtConcurrent>
 
 class networkprefixset : public QObject
 {
@@ -19,6 +28,25 @@ private slots:
     void modification();
     void iteration();
     void arithmetics();
+    void longestPrefixMatch();
+    void lookupTable();
+    void splitting();
+    void exclusion();
+    void permutation();
+    void parser();
+    void parallelLoading();
+    void aggregation();
+    void algebra();
+    void coverage();
+    void binaryFile();
+    void streaming();
+    void concurrentUpdates();
+    void prefixMap();
+    void batchLookup();
+
+private:
+    NetworkPrefix linearLongestPrefixMatch(const QVector<NetworkPrefix> &prefixes,
+                                           QHostAddress address);
 };
 
 networkprefixset::networkprefixset()
@@ -42,33 +70,33 @@ void networkprefixset::construction()
 {
     {
         NetworkPrefixSet prefixSet;
-        QVERIFY(static_cast<int>(prefixSet.addressCount()) == 0);
+        QVERIFY(prefixSet.addressCount() == 0);
         QVERIFY(prefixSet.prefixCount() == 0);
-        QVERIFY(prefixSet.nextAddress() == QHostAddress());
+        QVERIFY(NetworkPrefixSetCursor(prefixSet).nextAddress() == QHostAddress());
     }
 
     {
         QString filename(":/tst_input_correct.txt");
         NetworkPrefixSet prefixSet = NetworkPrefixSet::fromFile(filename);
         QVERIFY(prefixSet.prefixCount() == 10);
-        QVERIFY(qFloor(prefixSet.addressCount()) == 25395714);
-        QVERIFY(prefixSet.nextAddress() != QHostAddress());
+        QVERIFY(prefixSet.addressCount() == 25395714);
+        QVERIFY(NetworkPrefixSetCursor(prefixSet).nextAddress() != QHostAddress());
     }
 
     {
         QString filename(":/tst_input_correct.txt");
         NetworkPrefixSet prefixSet = NetworkPrefixSet::fromFile(filename, false, false);
         QVERIFY(prefixSet.prefixCount() == 10);
-        QVERIFY(qFloor(prefixSet.addressCount()) == 25395714);
-        QVERIFY(prefixSet.nextAddress() != QHostAddress());
+        QVERIFY(prefixSet.addressCount() == 25395714);
+        QVERIFY(NetworkPrefixSetCursor(prefixSet).nextAddress() != QHostAddress());
     }
 
     {
         QString filename(":/tst_input_with_duplicates.txt");
         NetworkPrefixSet prefixSet = NetworkPrefixSet::fromFile(filename);
         QVERIFY(prefixSet.prefixCount() == 13);
-        QVERIFY(qFloor(prefixSet.addressCount()) == 25527042);
-        QVERIFY(prefixSet.nextAddress() != QHostAddress());
+        QVERIFY(prefixSet.addressCount() == 25527042);
+        QVERIFY(NetworkPrefixSetCursor(prefixSet).nextAddress() != QHostAddress());
     }
 
     {
@@ -76,46 +104,46 @@ void networkprefixset::construction()
         NetworkPrefixSet prefixSet = NetworkPrefixSet::fromFile(filename, false, false);
         //qDebug() << "----> " << prefixSet.prefixCount();
         QVERIFY(prefixSet.prefixCount() == 10);
-        QVERIFY(qFloor(prefixSet.addressCount()) == 25395714);
-        QVERIFY(prefixSet.nextAddress() != QHostAddress());
+        QVERIFY(prefixSet.addressCount() == 25395714);
+        QVERIFY(NetworkPrefixSetCursor(prefixSet).nextAddress() != QHostAddress());
     }
 
     {
         QString filename(":/tst_input_with_errors.txt");
         NetworkPrefixSet prefixSet = NetworkPrefixSet::fromFile(filename);
         QVERIFY(prefixSet.prefixCount() == 0);
-        QVERIFY(qFloor(prefixSet.addressCount()) == 0);
-        QVERIFY(prefixSet.nextAddress() == QHostAddress());
+        QVERIFY(prefixSet.addressCount() == 0);
+        QVERIFY(NetworkPrefixSetCursor(prefixSet).nextAddress() == QHostAddress());
     }
 
     {
         QString filename(":/tst_input_with_errors.txt");
         NetworkPrefixSet prefixSet = NetworkPrefixSet::fromFile(filename, true);
         QVERIFY(prefixSet.prefixCount() == 13);
-        QVERIFY(qFloor(prefixSet.addressCount()) == 25527042);
-        QVERIFY(prefixSet.nextAddress() != QHostAddress());
+        QVERIFY(prefixSet.addressCount() == 25527042);
+        QVERIFY(NetworkPrefixSetCursor(prefixSet).nextAddress() != QHostAddress());
     }
 
     {
         QString filename(":/tst_input_with_errors.txt");
         NetworkPrefixSet prefixSet = NetworkPrefixSet::fromFile(filename, true, false);
         QVERIFY(prefixSet.prefixCount() == 10);
-        QVERIFY(qFloor(prefixSet.addressCount()) == 25395714);
-        QVERIFY(prefixSet.nextAddress() != QHostAddress());
+        QVERIFY(prefixSet.addressCount() == 25395714);
+        QVERIFY(NetworkPrefixSetCursor(prefixSet).nextAddress() != QHostAddress());
     }
 
     {
         QVector<NetworkPrefix> prefixes = {};
         NetworkPrefixSet prefixSet = NetworkPrefixSet::fromVector(prefixes);
         QVERIFY(prefixSet.prefixCount() == 0);
-        QVERIFY(qFloor(prefixSet.addressCount()) == 0);
+        QVERIFY(prefixSet.addressCount() == 0);
     }
 
     {
         QVector<NetworkPrefix> prefixes = {NetworkPrefix()};
         NetworkPrefixSet prefixSet = NetworkPrefixSet::fromVector(prefixes);
         QVERIFY(prefixSet.prefixCount() == 0);
-        QVERIFY(qFloor(prefixSet.addressCount()) == 0);
+        QVERIFY(prefixSet.addressCount() == 0);
     }
 
     {
@@ -123,11 +151,12 @@ void networkprefixset::construction()
                                            NetworkPrefix("1.2.3.0/24")};
         NetworkPrefixSet prefixSet = NetworkPrefixSet::fromVector(prefixes);
         QVERIFY(prefixSet.prefixCount() == 2);
-        QVERIFY(qFloor(prefixSet.addressCount()) == 512);
+        QVERIFY(prefixSet.addressCount() == 512);
 
         QVector<NetworkPrefix> prefixVectorFromSet = prefixSet.toVector();
+        NetworkPrefixSetCursor cursor(prefixSet);
         for (NetworkPrefix prefix : prefixVectorFromSet) {
-            QVERIFY(prefix == prefixSet.nextPrefix());
+            QVERIFY(prefix == cursor.nextPrefix());
         }
     }
 }
@@ -138,7 +167,7 @@ void networkprefixset::modification()
         NetworkPrefixSet prefixSet;
         prefixSet.addPrefix(NetworkPrefix(QHostAddress("192.168.0.0"), 16));
         QVERIFY(prefixSet.prefixCount() == 1);
-        QVERIFY(qFloor(prefixSet.addressCount()) == 65536);
+        QVERIFY(prefixSet.addressCount() == 65536);
         prefixSet.addPrefix(NetworkPrefix("192.168.0.0/16"), false);
         QVERIFY(prefixSet.prefixCount() == 1);
         prefixSet.addPrefix(NetworkPrefix("192.168.0.0/16"));
@@ -159,6 +188,95 @@ void networkprefixset::modification()
         QVERIFY(prefixSet.prefixCount() == 2);
         QVERIFY(prefixSet.contains(NetworkPrefix("192.168.0.0/16")));
     }
+
+    //deduplication is hashed, this would take minutes with linear scans
+    {
+        QVector<NetworkPrefix> prefixes;
+        for (quint32 i = 0; i < 200000; ++i) {
+            prefixes << NetworkPrefix::fromIpv4(i << 8, 24) << NetworkPrefix::fromIpv4(i << 8, 24);
+        }
+
+        NetworkPrefixSet prefixSet = NetworkPrefixSet::fromVector(prefixes, false);
+        QVERIFY(prefixSet.prefixCount() == 200000);
+        QVERIFY(prefixSet.contains(NetworkPrefix("0.1.0.0/24")));
+        QVERIFY(!prefixSet.contains(NetworkPrefix("0.1.0.0/23")));
+
+        prefixSet.addPrefix(NetworkPrefix("0.1.0.0/24"), false);
+        QVERIFY(prefixSet.prefixCount() == 200000);
+        prefixSet.removePrefix(NetworkPrefix("0.1.0.0/24"));
+        QVERIFY(!prefixSet.contains(NetworkPrefix("0.1.0.0/24")));
+        QVERIFY(!prefixSet.longestPrefixMatch(QHostAddress("0.1.0.1")).isValid());
+    }
+
+    //large IPv6 prefixes must not overflow the address count
+    {
+        NetworkPrefixSet prefixSet;
+        prefixSet.addPrefix(NetworkPrefix("2a03:4567::/32"));
+        prefixSet.addPrefix(NetworkPrefix("2a03:4568::/48"));
+        prefixSet.addPrefix(NetworkPrefix("10.0.0.0/8"));
+        QVERIFY(prefixSet.addressCount()
+                == (UInt128(1) << 96) + (UInt128(1) << 80) + (UInt128(1) << 24));
+
+        prefixSet.addPrefix(NetworkPrefix("::/0"));
+        QVERIFY(prefixSet.addressCount() == UInt128::max());
+    }
+
+    //copies share the prefixes until one of them is changed
+    {
+        QVector<NetworkPrefix> prefixes = {NetworkPrefix("10.0.0.0/8"),
+                                           NetworkPrefix(),
+                                           NetworkPrefix("10.0.0.0/8"),
+                                           NetworkPrefix("192.168.0.0/16")};
+        NetworkPrefixSet prefixSet = NetworkPrefixSet::fromVector(std::move(prefixes), false);
+        QVERIFY(prefixSet.prefixCount() == 2);
+        QVERIFY(prefixSet.toVector().last() == NetworkPrefix("192.168.0.0/16"));
+
+        NetworkPrefixSet copy = prefixSet;
+        copy.addPrefix(NetworkPrefix("172.16.0.0/12"));
+        copy.removePrefix(NetworkPrefix("10.0.0.0/8"));
+        QVERIFY(copy.prefixCount() == 2);
+        QVERIFY(prefixSet.prefixCount() == 2);
+        QVERIFY(prefixSet.longestPrefixMatch(QHostAddress("10.1.2.3")) == NetworkPrefix("10.0.0.0/8"));
+        QVERIFY(!prefixSet.contains(NetworkPrefix("172.16.0.0/12")));
+
+        copy.clear();
+        QVERIFY(prefixSet.contains(NetworkPrefix("10.0.0.0/8")));
+
+        NetworkPrefixSet moved = std::move(prefixSet);
+        QVERIFY(moved.prefixCount() == 2);
+        prefixSet = moved;
+        QVERIFY(prefixSet.contains(NetworkPrefix("192.168.0.0/16")));
+
+        //a moved-from set is empty and can still be used
+        NetworkPrefixSet other = std::move(moved);
+        QVERIFY(other.prefixCount() == 2);
+        QVERIFY(moved.prefixCount() == 0);
+        QVERIFY(moved.addressCount() == 0);
+        QVERIFY(moved.toVector().isEmpty());
+        QVERIFY(!moved.contains(NetworkPrefix("10.0.0.0/8")));
+        QVERIFY(!moved.longestPrefixMatch(QHostAddress("10.1.2.3")).isValid());
+        moved.addPrefix(NetworkPrefix("172.16.0.0/12"));
+        QVERIFY(moved.prefixCount() == 1);
+        QVERIFY(moved.contains(NetworkPrefix("172.16.0.0/12")));
+        QVERIFY(!other.contains(NetworkPrefix("172.16.0.0/12")));
+        moved.clear();
+        QVERIFY(moved.prefixCount() == 0);
+
+        //so is one moved from by assignment, and moved-from sets do not
+        //share changes
+        NetworkPrefixSet target;
+        target.addPrefix(NetworkPrefix("192.0.2.0/24"));
+        NetworkPrefixSet source = other;
+        target = std::move(source);
+        QVERIFY(target.prefixCount() == 2);
+        QVERIFY(!target.contains(NetworkPrefix("192.0.2.0/24")));
+        QVERIFY(source.prefixCount() == 0);
+        NetworkPrefixSet third = std::move(target);
+        source.addPrefix(NetworkPrefix("198.51.100.0/24"));
+        QVERIFY(source.prefixCount() == 1);
+        QVERIFY(target.prefixCount() == 0);
+        QVERIFY(third.prefixCount() == 2);
+    }
 }
 
 void networkprefixset::iteration()
@@ -167,10 +285,11 @@ void networkprefixset::iteration()
         NetworkPrefixSet prefixSet;
         prefixSet.addPrefix(NetworkPrefix("128.0.0.0/1"));
         prefixSet.addPrefix(NetworkPrefix("64.168.0.0/3")); //this gets truncated of course
+        NetworkPrefixSetCursor cursor(prefixSet);
         int cnt = 0;
-        while (prefixSet.hasMorePrefixes()) {
+        while (cursor.hasMorePrefixes()) {
             cnt++;
-            NetworkPrefix prefix = prefixSet.nextPrefix();
+            NetworkPrefix prefix = cursor.nextPrefix();
             if (cnt == 1) {
                 QVERIFY(NetworkPrefix("128.0.0.0/1") == prefix);
             } else {
@@ -184,10 +303,11 @@ void networkprefixset::iteration()
         NetworkPrefixSet prefixSet;
         prefixSet.addPrefix(NetworkPrefix("128.0.0.0/25"));
         prefixSet.addPrefix(NetworkPrefix("64.168.0.0/25"));
+        NetworkPrefixSetCursor cursor(prefixSet);
         int cnt = 0;
-        while (prefixSet.hasMoreAddresses()) {
+        while (cursor.hasMoreAddresses()) {
             ++cnt;
-            QHostAddress address = prefixSet.nextAddress();
+            QHostAddress address = cursor.nextAddress();
             //qDebug() << address;
         }
         //qDebug() << cnt;
@@ -199,14 +319,42 @@ void networkprefixset::iteration()
         NetworkPrefixSet prefixSet;
         prefixSet.addPrefix(NetworkPrefix("128.0.0.0/25"));
         prefixSet.addPrefix(NetworkPrefix("2001::FFFF:0/112"));
+        NetworkPrefixSetCursor cursor(prefixSet);
         int cnt = 0;
-        while (prefixSet.hasMoreAddresses()) {
+        while (cursor.hasMoreAddresses()) {
             ++cnt;
-            QHostAddress address = prefixSet.nextAddress();
+            QHostAddress address = cursor.nextAddress();
         }
         QVERIFY(cnt == 65664);
     }
 
+    {
+        //batches walk one family and skip the prefixes of the other
+        NetworkPrefixSet prefixSet;
+        prefixSet.addPrefix(NetworkPrefix("128.0.0.0/25"));
+        prefixSet.addPrefix(NetworkPrefix("2001::FFFF:0/112"));
+        prefixSet.addPrefix(NetworkPrefix("10.0.0.0/24"));
+        QVector<quint32> ipv4Buffer(100);
+        QVector<Q_IPV6ADDR> ipv6Buffer(1000);
+        NetworkPrefixSetCursor cursor(prefixSet);
+        int cnt = 0;
+        int written;
+
+        while ((written = cursor.nextAddresses(ipv4Buffer.data(), ipv4Buffer.count())) > 0) {
+            cnt += written;
+        }
+        QVERIFY(cnt == 384);
+        QVERIFY(ipv4Buffer[83] == 0x0a0000ff); //last one of the final batch of 84
+        QVERIFY(!cursor.hasMoreAddresses());
+
+        cursor.resetIterator();
+        cnt = 0;
+        while ((written = cursor.nextAddresses(ipv6Buffer.data(), ipv6Buffer.count())) > 0) {
+            cnt += written;
+        }
+        QVERIFY(cnt == 65536);
+    }
+
     {
         //add Null prefixes to see whether it works or not
         NetworkPrefixSet prefixSet;
@@ -214,13 +362,79 @@ void networkprefixset::iteration()
         prefixSet.addPrefix(NetworkPrefix("192.168.0.0/24"));
         prefixSet.addPrefix(NetworkPrefix());
         prefixSet.addPrefix(NetworkPrefix());
+        NetworkPrefixSetCursor cursor(prefixSet);
         int cnt = 0;
-        while (prefixSet.hasMoreAddresses()) {
+        while (cursor.hasMoreAddresses()) {
             ++cnt;
-            QHostAddress address = prefixSet.nextAddress();
+            QHostAddress address = cursor.nextAddress();
         }
         QVERIFY(cnt == 256);
     }
+
+    {
+        //cursors on a const set are independent of each other, nextPrefix()
+        //moves on no matter how much of the current prefix has been walked
+        NetworkPrefixSet prefixSet;
+        prefixSet.addPrefix(NetworkPrefix("10.0.0.0/30"));
+        prefixSet.addPrefix(NetworkPrefix("10.0.1.0/30"));
+        const NetworkPrefixSet &constSet = prefixSet;
+        NetworkPrefixSetCursor first(constSet);
+        NetworkPrefixSetCursor second(constSet);
+
+        QVERIFY(first.nextAddress() == QHostAddress("10.0.0.0"));
+        QVERIFY(first.nextPrefix() == NetworkPrefix("10.0.0.0/30"));
+        QVERIFY(first.nextAddress() == QHostAddress("10.0.1.0"));
+        QVERIFY(second.nextAddress() == QHostAddress("10.0.0.0"));
+
+        //later changes to the set do not show up in existing cursors
+        prefixSet.clear();
+        QVERIFY(second.hasMoreAddresses());
+        QVERIFY(!NetworkPrefixSetCursor(prefixSet).hasMoreAddresses());
+    }
+
+    {
+        //the union cursor walks every covered address once, in ascending order
+        NetworkPrefixSet prefixSet;
+        prefixSet.addPrefix(NetworkPrefix("2001:db8::/126"));
+        prefixSet.addPrefix(NetworkPrefix("10.0.0.0/22"));
+        prefixSet.addPrefix(NetworkPrefix("10.0.1.0/24"));
+        prefixSet.addPrefix(NetworkPrefix("10.0.4.0/24")); //adjacent to 10.0.0.0/22
+        prefixSet.addPrefix(NetworkPrefix("192.168.0.0/30"));
+        prefixSet.addPrefix(NetworkPrefix("192.168.0.0/30"));
+        prefixSet.addPrefix(NetworkPrefix());
+        NetworkPrefixSetUnionCursor cursor(prefixSet);
+
+        QVector<QHostAddress> addresses;
+        while (cursor.hasMoreAddresses()) {
+            addresses << cursor.nextAddress();
+        }
+        QVERIFY(cursor.nextAddress().isNull());
+        QVERIFY(addresses.count() == 1280 + 4 + 4);
+        QVERIFY(addresses.first() == QHostAddress("10.0.0.0"));
+        QVERIFY(addresses[1279] == QHostAddress("10.0.4.255"));
+        QVERIFY(addresses[1280] == QHostAddress("192.168.0.0"));
+        QVERIFY(addresses.last() == QHostAddress("2001:db8::3"));
+        for (int i = 1; i < 1284; ++i) {
+            QVERIFY(addresses[i - 1].toIPv4Address() < addresses[i].toIPv4Address());
+        }
+
+        //batches skip the other family, ranges hand out the rest of an interval
+        cursor.resetIterator();
+        QVector<quint32> ipv4Buffer(1000);
+        Q_IPV6ADDR ipv6Buffer[8];
+        QVERIFY(cursor.nextAddresses(ipv4Buffer.data(), ipv4Buffer.count()) == 1000);
+        QVERIFY(cursor.nextRange() == NetworkAddressRange(QHostAddress("10.0.3.232"), QHostAddress("10.0.4.255")));
+        QVERIFY(cursor.nextAddresses(ipv6Buffer, 8) == 4);
+        QVERIFY(QHostAddress(ipv6Buffer[3]) == QHostAddress("2001:db8::3"));
+        QVERIFY(!cursor.hasMoreAddresses());
+        QVERIFY(!cursor.nextRange().isValid());
+
+        cursor.resetIterator();
+        QVERIFY(cursor.nextRange().addressCount() == 1280);
+        QVERIFY(cursor.nextRange().addressCount() == 4);
+        QVERIFY(cursor.nextRange().first() == QHostAddress("2001:db8::"));
+        QVERIFY(!NetworkPrefixSetUnionCursor(NetworkPrefixSet()).hasMoreAddresses());
+    }
 }
 
 void networkprefixset::arithmetics()
@@ -256,7 +470,7 @@ void networkprefixset::arithmetics()
         //        qDebug() << "address sum: "
         //                 << static_cast<quint64>(prefixSet.addressCount() + invertedSet.addressCount());
 
-        QVERIFY(static_cast<quint64>(prefixSet.addressCount() + invertedSet.addressCount())
+        QVERIFY((prefixSet.addressCount() + invertedSet.addressCount())
                 == qNextPowerOfTwo(static_cast<quint64>(4000000000)));
         //        QFile outFile("/Users/rolf/Documents/code/qt-networkprefix/tests/tst_networkprefixset/"
         //                      "tst_input_all_public_ipv4.txt");
@@ -275,6 +489,37 @@ void networkprefixset::arithmetics()
         }
     }
 
+    //both families, overlapping input, and inside of a bounding prefix
+    {
+        NetworkPrefixSet prefixSet;
+        prefixSet.addPrefix(NetworkPrefix("10.0.0.0/9"));
+        prefixSet.addPrefix(NetworkPrefix("10.0.0.0/8"));
+        prefixSet.addPrefix(NetworkPrefix("10.128.0.0/9"));
+        prefixSet.addPrefix(NetworkPrefix("2001:db8::/32"));
+
+        NetworkPrefixSet invertedSet = NetworkPrefixSet::invert(prefixSet);
+        QVERIFY(invertedSet.prefixCount() == 8 + 32);
+        QVERIFY(invertedSet.toVector().first() == NetworkPrefix("0.0.0.0/5"));
+        QVERIFY(invertedSet.toVector().last() == NetworkPrefix("8000::/1"));
+        QVERIFY(!invertedSet.isCoveredBySet(NetworkPrefix("10.1.2.3/32")));
+        QVERIFY(invertedSet.isCoveredBySet(NetworkPrefix("11.0.0.0/8")));
+        QVERIFY(invertedSet.isCoveredBySet(NetworkPrefix("2001:db9::/32")));
+
+        NetworkPrefixSet bounded = NetworkPrefixSet::invert(prefixSet, NetworkPrefix("2001:db8::/31"));
+        QVERIFY(bounded.toVector() == QVector<NetworkPrefix>{NetworkPrefix("2001:db9::/32")});
+
+        QVERIFY(NetworkPrefixSet::invert(prefixSet, NetworkPrefix("10.1.0.0/16")).toVector().isEmpty());
+        QVERIFY(NetworkPrefixSet::invert(NetworkPrefixSet(), NetworkPrefix("::/0")).toVector()
+                == QVector<NetworkPrefix>{NetworkPrefix("::/0")});
+        QVERIFY(NetworkPrefixSet::invert(NetworkPrefixSet()).toVector()
+                == QVector<NetworkPrefix>{NetworkPrefix("0.0.0.0/0")});
+
+        NetworkPrefixSet ipv6Only;
+        ipv6Only.addPrefix(NetworkPrefix("8000::/1"));
+        QVERIFY(NetworkPrefixSet::invert(ipv6Only).toVector()
+                == (QVector<NetworkPrefix>{NetworkPrefix("0.0.0.0/0"), NetworkPrefix("::/1")}));
+    }
+
     //longest prefix match tests
     {
         NetworkPrefixSet prefixes;
@@ -291,6 +536,1003 @@ void networkprefixset::arithmetics()
     }
 }
 
+void networkprefixset::longestPrefixMatch()
+{
+    //nested and overlapping prefixes of both families
+    {
+        NetworkPrefixSet prefixes;
+        prefixes.addPrefix(NetworkPrefix("0.0.0.0/0"));
+        prefixes.addPrefix(NetworkPrefix("10.0.0.0/8"));
+        prefixes.addPrefix(NetworkPrefix("10.1.0.0/16"));
+        prefixes.addPrefix(NetworkPrefix("10.1.2.3/32"));
+        prefixes.addPrefix(NetworkPrefix("2001:db8::/32"));
+        prefixes.addPrefix(NetworkPrefix("2001:db8:1::/48"));
+        prefixes.addPrefix(NetworkPrefix("2001:db8:1::1/128"));
+
+        QVERIFY(prefixes.longestPrefixMatch(QHostAddress("10.1.2.3"))
+                == NetworkPrefix("10.1.2.3/32"));
+        QVERIFY(prefixes.longestPrefixMatch(QHostAddress("10.1.2.4"))
+                == NetworkPrefix("10.1.0.0/16"));
+        QVERIFY(prefixes.longestPrefixMatch(QHostAddress("10.2.0.0"))
+                == NetworkPrefix("10.0.0.0/8"));
+        QVERIFY(prefixes.longestPrefixMatch(QHostAddress("11.0.0.0"))
+                == NetworkPrefix("0.0.0.0/0"));
+        QVERIFY(prefixes.longestPrefixMatch(QHostAddress("2001:db8:1::1"))
+                == NetworkPrefix("2001:db8:1::1/128"));
+        QVERIFY(prefixes.longestPrefixMatch(QHostAddress("2001:db8:1::2"))
+                == NetworkPrefix("2001:db8:1::/48"));
+        QVERIFY(prefixes.longestPrefixMatch(QHostAddress("2001:db8:2::"))
+                == NetworkPrefix("2001:db8::/32"));
+        QVERIFY(prefixes.longestPrefixMatch(QHostAddress("2001:db9::")) == NetworkPrefix());
+        QVERIFY(prefixes.longestPrefixMatch(QHostAddress()) == NetworkPrefix());
+
+        //the index has to follow removals, duplicates have to be removed
+        //as often as they were added
+        prefixes.addPrefix(NetworkPrefix("10.1.0.0/16"));
+        prefixes.removePrefix(NetworkPrefix("10.1.0.0/16"));
+        QVERIFY(prefixes.longestPrefixMatch(QHostAddress("10.1.2.4"))
+                == NetworkPrefix("10.1.0.0/16"));
+        prefixes.removePrefix(NetworkPrefix("10.1.0.0/16"));
+        QVERIFY(prefixes.longestPrefixMatch(QHostAddress("10.1.2.4"))
+                == NetworkPrefix("10.0.0.0/8"));
+        QVERIFY(prefixes.longestPrefixMatch(QHostAddress("10.1.2.3"))
+                == NetworkPrefix("10.1.2.3/32"));
+        prefixes.removePrefix(NetworkPrefix("0.0.0.0/0"));
+        QVERIFY(prefixes.longestPrefixMatch(QHostAddress("11.0.0.0")) == NetworkPrefix());
+
+        prefixes.clear();
+        QVERIFY(prefixes.longestPrefixMatch(QHostAddress("10.1.2.3")) == NetworkPrefix());
+    }
+
+    //compare against a linear scan with pseudo random prefixes and addresses
+    {
+        quint32 state = 4711;
+        auto random = [&state]() {
+            state = state * 1103515245 + 12345;
+            return state;
+        };
+
+        QVector<NetworkPrefix> prefixes;
+        for (int i = 0; i < 500; ++i) {
+            quint32 address = random() & 0xff0fffff;
+            prefixes.append(NetworkPrefix(QHostAddress(address), static_cast<int>(random() % 33)));
+
+            Q_IPV6ADDR v6Address;
+            for (int j = 0; j < 16; ++j) {
+                v6Address[j] = static_cast<quint8>(j < 2 ? 0x20 : random() >> 24);
+            }
+            prefixes.append(
+                NetworkPrefix(QHostAddress(v6Address), 16 + static_cast<int>(random() % 113)));
+        }
+
+        NetworkPrefixSet prefixSet = NetworkPrefixSet::fromVector(prefixes);
+
+        for (int i = 0; i < 2000; ++i) {
+            QHostAddress address;
+            if (i % 2) {
+                address = QHostAddress(random() & 0xff0fffff);
+            } else {
+                Q_IPV6ADDR v6Address = prefixes[i % prefixes.count()].address().toIPv6Address();
+                v6Address[15 - (i % 14)] ^= static_cast<quint8>(random() >> 24);
+                address = QHostAddress(v6Address);
+            }
+
+            QVERIFY(prefixSet.longestPrefixMatch(address)
+                    == linearLongestPrefixMatch(prefixes, address));
+        }
+
+        //remove half of the prefixes again and check the index is still in sync
+        for (int i = 0; i < prefixes.count(); i += 2) {
+            prefixSet.removePrefix(prefixes[i]);
+        }
+
+        QVector<NetworkPrefix> remaining = prefixSet.toVector();
+        for (const NetworkPrefix &prefix : prefixes) {
+            QVERIFY(prefixSet.longestPrefixMatch(prefix.address())
+                    == linearLongestPrefixMatch(remaining, prefix.address()));
+        }
+    }
+}
+
+void networkprefixset::lookupTable()
+{
+    {
+        NetworkPrefixLookupTable table;
+        QVERIFY(table.isEmpty());
+        QVERIFY(table.lookup(0x01020304) == -1);
+        QVERIFY(table.longestPrefixMatch(QHostAddress("1.2.3.4")) == NetworkPrefix());
+    }
+
+    {
+        NetworkPrefixSet prefixes;
+        prefixes.addPrefix(NetworkPrefix("0.0.0.0/0"));
+        prefixes.addPrefix(NetworkPrefix("10.0.0.0/8"));
+        prefixes.addPrefix(NetworkPrefix("10.1.2.0/24"));
+        prefixes.addPrefix(NetworkPrefix("10.1.2.128/25"));
+        prefixes.addPrefix(NetworkPrefix("10.1.2.130/32"));
+        prefixes.addPrefix(NetworkPrefix("10.1.2.130/32"));
+        prefixes.addPrefix(NetworkPrefix("2001:db8::/32"));
+
+        NetworkPrefixLookupTable table = NetworkPrefixLookupTable::compile(prefixes);
+        QVERIFY(table.prefixCount() == 5);
+
+        QVERIFY(table.longestPrefixMatch(QHostAddress("10.1.2.130"))
+                == NetworkPrefix("10.1.2.130/32"));
+        QVERIFY(table.longestPrefixMatch(QHostAddress("10.1.2.131"))
+                == NetworkPrefix("10.1.2.128/25"));
+        QVERIFY(table.longestPrefixMatch(QHostAddress("10.1.2.127"))
+                == NetworkPrefix("10.1.2.0/24"));
+        QVERIFY(table.longestPrefixMatch(QHostAddress("10.1.3.0")) == NetworkPrefix("10.0.0.0/8"));
+        QVERIFY(table.longestPrefixMatch(QHostAddress("11.0.0.0")) == NetworkPrefix("0.0.0.0/0"));
+        QVERIFY(table.longestPrefixMatch(QHostAddress("2001:db8::1")) == NetworkPrefix());
+
+        //the table is a snapshot and does not see later changes
+        prefixes.removePrefix(NetworkPrefix("0.0.0.0/0"));
+        QVERIFY(table.longestPrefixMatch(QHostAddress("11.0.0.0")) == NetworkPrefix("0.0.0.0/0"));
+        table = NetworkPrefixLookupTable::compile(prefixes);
+        QVERIFY(table.longestPrefixMatch(QHostAddress("11.0.0.0")) == NetworkPrefix());
+    }
+
+    //the set's own longestPrefixMatch is the reference
+    {
+        quint32 state = 815;
+        auto random = [&state]() {
+            state = state * 1103515245 + 12345;
+            return state;
+        };
+
+        NetworkPrefixSet prefixes;
+        for (int i = 0; i < 2000; ++i) {
+            quint32 address = random() & 0x0f0fff0f;
+            prefixes.addPrefix(NetworkPrefix(QHostAddress(address), 8 + static_cast<int>(random() % 25)));
+        }
+
+        NetworkPrefixLookupTable table = NetworkPrefixLookupTable::compile(prefixes);
+
+        for (int i = 0; i < 20000; ++i) {
+            QHostAddress address(random() & 0x0f0fff3f);
+            QVERIFY(table.longestPrefixMatch(address) == prefixes.longestPrefixMatch(address));
+        }
+    }
+}
+
+NetworkPrefix networkprefixset::linearLongestPrefixMatch(const QVector<NetworkPrefix> &prefixes,
+                                                         QHostAddress address)
+{
+    NetworkPrefix returnPrefix;
+
+    for (NetworkPrefix prefix : prefixes) {
+        if (prefix.containsAddress(address) && prefix.prefixLength() > returnPrefix.prefixLength()) {
+            returnPrefix = prefix;
+        }
+    }
+
+    return returnPrefix;
+}
+
+void networkprefixset::splitting()
+{
+    //balanced by addresses, not by prefixes
+    {
+        NetworkPrefixSet prefixSet;
+        prefixSet.addPrefix(NetworkPrefix("10.0.0.0/16"));
+        prefixSet.addPrefix(NetworkPrefix("192.168.0.0/24"));
+        prefixSet.addPrefix(NetworkPrefix("2001:db8::/120"));
+        prefixSet.addPrefix(NetworkPrefix("172.16.0.0/18"));
+
+        const int shardCount = 5;
+        QVector<NetworkPrefixShard> shards = prefixSet.split(shardCount);
+        QVERIFY(shards.count() == shardCount);
+
+        UInt128 remainder;
+        const UInt128 size = UInt128::divide(prefixSet.addressCount(), shardCount, &remainder);
+        UInt128 total = 0;
+        for (const NetworkPrefixShard &shard : shards) {
+            QVERIFY(shard.addressCount() == size || shard.addressCount() == size + 1);
+            total += shard.addressCount();
+        }
+        QVERIFY(total == prefixSet.addressCount());
+
+        //draining all shards one after another gives the same addresses as the set
+        NetworkPrefixSetCursor cursor(prefixSet);
+        for (NetworkPrefixShard &shard : shards) {
+            while (shard.hasMoreAddresses()) {
+                QVERIFY(shard.nextAddress() == cursor.nextAddress());
+            }
+            QVERIFY(shard.nextAddress().isNull());
+        }
+        QVERIFY(!cursor.hasMoreAddresses());
+    }
+
+    {
+        NetworkPrefixSet prefixSet;
+        prefixSet.addPrefix(NetworkPrefix("10.0.0.0/31"));
+        prefixSet.addPrefix(NetworkPrefix("10.0.1.0/32"));
+        QVector<NetworkPrefixShard> shards = prefixSet.split(8);
+        QVERIFY(shards.count() == 3);
+        QVERIFY(shards[2].ranges().first().first() == QHostAddress("10.0.1.0"));
+        QVERIFY(NetworkPrefixSet().split(8).isEmpty());
+        QVERIFY(prefixSet.split(0).isEmpty());
+    }
+}
+
+void networkprefixset::exclusion()
+{
+    {
+        NetworkPrefixSet include;
+        include.addPrefix(NetworkPrefix("10.0.0.0/24"));
+        include.addPrefix(NetworkPrefix("10.0.0.128/25"));
+        include.addPrefix(NetworkPrefix("2001:db8::/124"));
+        NetworkPrefixSet exclude;
+        exclude.addPrefix(NetworkPrefix("10.0.0.0/30"));
+        exclude.addPrefix(NetworkPrefix("10.0.0.16/28"));
+        exclude.addPrefix(NetworkPrefix("10.0.0.20/30")); //inside the one before
+        exclude.addPrefix(NetworkPrefix("10.0.0.255/32"));
+        exclude.addPrefix(NetworkPrefix("2001:db8::8/125"));
+        exclude.addPrefix(NetworkPrefix("192.168.0.0/16")); //outside of include
+
+        NetworkPrefixSetExclusionCursor cursor(include, exclude);
+        QSet<QString> seen;
+        QHostAddress previous;
+        while (cursor.hasMoreAddresses()) {
+            const QHostAddress address = cursor.nextAddress();
+            QVERIFY(!address.isNull());
+            QVERIFY(include.isCoveredBySet(NetworkPrefix(address)));
+            QVERIFY(!exclude.isCoveredBySet(NetworkPrefix(address)));
+            QVERIFY(!seen.contains(address.toString()));
+            if (previous.protocol() == QAbstractSocket::IPv4Protocol
+                && address.protocol() == QAbstractSocket::IPv4Protocol) {
+                QVERIFY(previous.toIPv4Address() < address.toIPv4Address());
+            }
+            seen.insert(address.toString());
+            previous = address;
+        }
+        QVERIFY(cursor.nextAddress().isNull());
+        QVERIFY(seen.count() == 256 - 4 - 16 - 1 + 8);
+        QVERIFY(seen.contains("10.0.0.4") && seen.contains("10.0.0.254") && seen.contains("2001:db8::7"));
+
+        cursor.resetIterator();
+        QVERIFY(cursor.nextAddress() == QHostAddress("10.0.0.4"));
+        QVERIFY(cursor.nextRange() == NetworkAddressRange(QHostAddress("10.0.0.5"), QHostAddress("10.0.0.15")));
+        QVERIFY(cursor.nextRange() == NetworkAddressRange(QHostAddress("10.0.0.32"), QHostAddress("10.0.0.254")));
+
+        Q_IPV6ADDR buffer[16];
+        QVERIFY(cursor.nextAddresses(buffer, 16) == 8);
+        QVERIFY(QHostAddress(buffer[7]) == QHostAddress("2001:db8::7"));
+        QVERIFY(!cursor.hasMoreAddresses());
+        QVERIFY(!cursor.nextRange().isValid());
+
+        //the other way round 192.168.0.0/16 is left, nothing is left of a set minus itself
+        QVERIFY(NetworkPrefixSetExclusionCursor(exclude, include).nextRange().addressCount() == 65536);
+        QVERIFY(!NetworkPrefixSetExclusionCursor(include, include).hasMoreAddresses());
+        QVERIFY(!NetworkPrefixSetExclusionCursor().hasMoreAddresses());
+    }
+
+    //the whole address space minus the bogons, range by range; agrees with
+    //subtract() without building the difference
+    {
+        NetworkPrefixSet include;
+        include.addPrefix(NetworkPrefix("0.0.0.0/0"));
+        include.addPrefix(NetworkPrefix("::/0"));
+        NetworkPrefixSet exclude = NetworkPrefixSet::fromFile(":/tst_input_not_for_general_use_ipv4.txt");
+        exclude.addPrefix(NetworkPrefix("2001:db8::/32"));
+        exclude.addPrefix(NetworkPrefix("fe80::/10"));
+        QVERIFY(exclude.prefixCount() > 2);
+
+        const NetworkPrefixSet difference = NetworkPrefixSet::subtract(include, exclude);
+        NetworkPrefixSetExclusionCursor cursor(include, exclude);
+        UInt128 ipv4 = 0;
+        UInt128 ipv6 = 0;
+        int ranges = 0;
+
+        for (NetworkAddressRange range = cursor.nextRange(); range.isValid(); range = cursor.nextRange()) {
+            (range.isIpv4() ? ipv4 : ipv6) += range.addressCount();
+            QVERIFY(!exclude.isCoveredBySet(NetworkPrefix(range.first())));
+            QVERIFY(!exclude.isCoveredBySet(NetworkPrefix(range.last())));
+            ++ranges;
+        }
+
+        QVERIFY(ipv4 == difference.coveredAddressCount(QAbstractSocket::IPv4Protocol));
+        QVERIFY(ipv6 == difference.coveredAddressCount(QAbstractSocket::IPv6Protocol));
+        QVERIFY(ranges > 2);
+
+        cursor.resetIterator();
+        QVERIFY(cursor.nextAddress() == QHostAddress("1.0.0.0"));
+    }
+}
+
+void networkprefixset::permutation()
+{
+    NetworkPrefixSet prefixSet;
+    prefixSet.addPrefix(NetworkPrefix("10.0.0.0/22"));
+    prefixSet.addPrefix(NetworkPrefix("2001:db8::/118"));
+    prefixSet.addPrefix(NetworkPrefix("192.168.0.0/30"));
+
+    NetworkAddressPermutation permutation = prefixSet.permutation(1234);
+    QVERIFY(permutation.addressCount() == prefixSet.addressCount());
+
+    QSet<QString> seen;
+    while (permutation.hasMoreAddresses()) {
+        const QHostAddress address = permutation.nextAddress();
+        QVERIFY(!seen.contains(address.toString()));
+        seen.insert(address.toString());
+    }
+    QVERIFY(seen.count() == 2052);
+
+    NetworkPrefixSetCursor cursor(prefixSet);
+    while (cursor.hasMoreAddresses()) {
+        QVERIFY(seen.contains(cursor.nextAddress().toString()));
+    }
+}
+
+void networkprefixset::parser()
+{
+    //has to agree with QHostAddress::parseSubnet() on everything
+    {
+        const QVector<QByteArray> inputs = {"192.168.11.0/23",
+                                            "10.0",
+                                            "10.0.",
+                                            "172.16.5",
+                                            "010.001.0.0/16",
+                                            "1.2.3.4.",
+                                            "1.2.3.4.5",
+                                            "1..2",
+                                            "256.0.0.0",
+                                            "10.0.0.0/33",
+                                            "10.0.0.0/",
+                                            "10.0.0.0/255.255.0.0",
+                                            "10.0.0.0/255.0.255.0",
+                                            "10.0.0.0/0",
+                                            "10.1.2.3/0.0.0.0",
+                                            "2a03:4567:abcd:83:dead:beef:25d4::/109",
+                                            "::",
+                                            "::/0",
+                                            "::1",
+                                            "1::",
+                                            "::ffff:192.168.1.1/120",
+                                            "1:2:3:4:5:6:7:8",
+                                            "1:2:3:4:5:6:7::8",
+                                            "1:2::3::4",
+                                            "1:2:3:4:5:6:7:8:9",
+                                            "12345::",
+                                            "fe80::1/129",
+                                            "fe80::1/64/64",
+                                            "2001:DB8::/32",
+                                            "1.2.3.4:5",
+                                            "",
+                                            "garbage"};
+
+        for (const QByteArray &input : inputs) {
+            const NetworkPrefix expected(QString::fromUtf8(input.constData(), input.size()));
+            const NetworkPrefix parsed = NetworkPrefixParser::parsePrefix(input);
+            QVERIFY(parsed == expected);
+        }
+    }
+
+    //lines, comments and errors with line numbers
+    {
+        const QByteArray data("# a comment\n"
+                              "  10.0.0.0/8  \r\n"
+                              "\n"
+                              "\t2001:db8::/32\n"
+                              "not a prefix\n"
+                              "192.168.0.0/16");
+
+        NetworkPrefixParser strictParser;
+        QVERIFY(!strictParser.parse(data));
+        QVERIFY(strictParser.prefixes().count() == 2);
+        QVERIFY(strictParser.errors().count() == 1);
+        QVERIFY(strictParser.errors().first().line == 5);
+        QVERIFY(strictParser.errors().first().text == QByteArray("not a prefix"));
+
+        NetworkPrefixParser skippingParser(true);
+        QVERIFY(skippingParser.parse(data, 101));
+        QVERIFY(skippingParser.prefixes().count() == 3);
+        QVERIFY(skippingParser.prefixes().last() == NetworkPrefix("192.168.0.0/16"));
+        QVERIFY(skippingParser.errors().first().line == 105);
+
+        NetworkPrefixParser otherComments(false, "//");
+        QVERIFY(!otherComments.parse(data));
+        QVERIFY(otherComments.errors().first().line == 1);
+    }
+}
+
+void networkprefixset::parallelLoading()
+{
+    //same results as the sequential loader, with all options
+    {
+        const QStringList filenames = {":/tst_input_correct.txt",
+                                       ":/tst_input_with_duplicates.txt",
+                                       ":/tst_input_with_errors.txt",
+                                       ":/tst_input_not_for_general_use_ipv4.txt"};
+
+        for (const QString &filename : filenames) {
+            for (int options = 0; options < 4; ++options) {
+                const bool skipUnparsableLines = options & 1;
+                const bool allowDuplicates = options & 2;
+                NetworkPrefixSet sequential = NetworkPrefixSet::fromFile(filename,
+                                                                         skipUnparsableLines,
+                                                                         allowDuplicates);
+                NetworkPrefixSet parallel = NetworkPrefixSet::fromFileParallel(filename,
+                                                                               skipUnparsableLines,
+                                                                               allowDuplicates);
+                QVERIFY(parallel.toVector() == sequential.toVector());
+            }
+        }
+    }
+
+    //chunks are cut at line boundaries and errors keep their line numbers
+    {
+        QByteArray data;
+        for (int i = 0; i < 20000; ++i) {
+            data += QString("10.%1.%2.0/24\n").arg(i / 256).arg(i % 256).toUtf8();
+            if (i == 15000) {
+                data += "# comment\n\nbroken line\n";
+            }
+        }
+
+        NetworkPrefixParser sequential(true);
+        NetworkPrefixParser parallel(true);
+        QVERIFY(sequential.parse(data));
+        QVERIFY(parallel.parseParallel(data.constData(), data.constData() + data.size(), 1, 7));
+        QVERIFY(parallel.prefixes() == sequential.prefixes());
+        QVERIFY(parallel.prefixes().count() == 20000);
+        QVERIFY(parallel.errors().count() == 1);
+        QVERIFY(parallel.errors().first().line == 15004);
+
+        NetworkPrefixParser strict;
+        QVERIFY(!strict.parseParallel(data.constData(), data.constData() + data.size(), 1, 7));
+        QVERIFY(strict.prefixes().count() == 15001);
+        QVERIFY(strict.errors().first().line == 15004);
+    }
+}
+
+void networkprefixset::aggregation()
+{
+    //siblings merge up as far as they go, contained prefixes disappear
+    {
+        QVector<NetworkPrefix> prefixes = {NetworkPrefix("10.0.0.128/26"),
+                                           NetworkPrefix("10.0.0.0/25"),
+                                           NetworkPrefix("10.0.0.192/26"),
+                                           NetworkPrefix("10.0.1.0/24"),
+                                           NetworkPrefix("10.0.1.7/32"),
+                                           NetworkPrefix("10.0.3.0/24"),
+                                           NetworkPrefix("2001:db8::/33"),
+                                           NetworkPrefix("2001:db8:8000::/33"),
+                                           NetworkPrefix("2001:db8::1/128")};
+        NetworkPrefixSet set = NetworkPrefixSet::fromVector(prefixes, true);
+
+        QVector<QPair<NetworkPrefix, NetworkPrefix>> folded;
+        NetworkPrefixSet aggregated = NetworkPrefixSet::aggregate(set, &folded);
+
+        const QVector<NetworkPrefix> expected = {NetworkPrefix("10.0.0.0/23"),
+                                                 NetworkPrefix("10.0.3.0/24"),
+                                                 NetworkPrefix("2001:db8::/32")};
+        QVERIFY(aggregated.toVector() == expected);
+
+        QVERIFY(folded.count() == prefixes.count());
+        for (const NetworkPrefix &prefix : prefixes) {
+            const NetworkPrefix output = prefix.isIpv4() && prefix.rawAddress() < 0x0a000300
+                                             ? expected[0]
+                                             : prefix.isIpv4() ? expected[1] : expected[2];
+            QVERIFY(folded.contains(qMakePair(prefix, output)));
+        }
+
+        QVERIFY(NetworkPrefixSet::aggregate(NetworkPrefixSet()).toVector().isEmpty());
+    }
+
+    //random input covers the same addresses afterwards, and nothing in the
+    //output can be aggregated any further
+    {
+        quint32 state = 13;
+        auto random = [&state]() {
+            state = state * 1103515245 + 12345;
+            return state >> 8;
+        };
+
+        QVector<NetworkPrefix> prefixes;
+        for (int i = 0; i < 100000; ++i) {
+            const int length = 16 + static_cast<int>(random() % 9);
+            const quint32 address = 0x0a000000 | (random() & 0x003fffff);
+            prefixes.append(NetworkPrefix::fromIpv4(address, length));
+        }
+        NetworkPrefixSet set = NetworkPrefixSet::fromVector(prefixes, true);
+
+        NetworkPrefixSet aggregated = NetworkPrefixSet::aggregate(set);
+        const QVector<NetworkPrefix> outputs = aggregated.toVector();
+
+        for (int i = 1; i < outputs.count(); ++i) {
+            QVERIFY(outputs[i - 1].rawAddress() < outputs[i].rawAddress());
+            QVERIFY(!NetworkPrefix(outputs[i - 1]).canAggregate(outputs[i]));
+        }
+
+        for (int i = 0; i < 2000; ++i) {
+            QHostAddress address(0x0a000000 | (random() & 0x003fffff));
+            QVERIFY(aggregated.longestPrefixMatch(address).isValid()
+                    == set.longestPrefixMatch(address).isValid());
+        }
+    }
+}
+
+void networkprefixset::algebra()
+{
+    {
+        NetworkPrefixSet announced;
+        announced.addPrefix(NetworkPrefix("10.0.0.0/8"));
+        announced.addPrefix(NetworkPrefix("192.168.0.0/24"));
+        announced.addPrefix(NetworkPrefix("2001:db8::/32"));
+
+        NetworkPrefixSet excluded;
+        excluded.addPrefix(NetworkPrefix("10.0.0.0/9"));
+        excluded.addPrefix(NetworkPrefix("172.16.0.0/12"));
+        excluded.addPrefix(NetworkPrefix("2001:db8:8000::/33"));
+
+        QVERIFY(NetworkPrefixSet::subtract(announced, excluded).toVector()
+                == (QVector<NetworkPrefix>{NetworkPrefix("10.128.0.0/9"),
+                                           NetworkPrefix("192.168.0.0/24"),
+                                           NetworkPrefix("2001:db8::/33")}));
+        QVERIFY(NetworkPrefixSet::intersect(announced, excluded).toVector()
+                == (QVector<NetworkPrefix>{NetworkPrefix("10.0.0.0/9"),
+                                           NetworkPrefix("2001:db8:8000::/33")}));
+        QVERIFY(NetworkPrefixSet::unite(announced, excluded).toVector()
+                == (QVector<NetworkPrefix>{NetworkPrefix("10.0.0.0/8"),
+                                           NetworkPrefix("172.16.0.0/12"),
+                                           NetworkPrefix("192.168.0.0/24"),
+                                           NetworkPrefix("2001:db8::/32")}));
+        QVERIFY(NetworkPrefixSet::symmetricDifference(announced, excluded).toVector()
+                == (QVector<NetworkPrefix>{NetworkPrefix("10.128.0.0/9"),
+                                           NetworkPrefix("172.16.0.0/12"),
+                                           NetworkPrefix("192.168.0.0/24"),
+                                           NetworkPrefix("2001:db8::/33")}));
+
+        //adjacent halves of different sets join up
+        NetworkPrefixSet low;
+        low.addPrefix(NetworkPrefix("0.0.0.0/1"));
+        NetworkPrefixSet high;
+        high.addPrefix(NetworkPrefix("128.0.0.0/1"));
+        QVERIFY(NetworkPrefixSet::unite(low, high).toVector()
+                == QVector<NetworkPrefix>{NetworkPrefix("0.0.0.0/0")});
+        QVERIFY(NetworkPrefixSet::intersect(low, high).toVector().isEmpty());
+        QVERIFY(NetworkPrefixSet::subtract(low, NetworkPrefixSet()).toVector() == low.toVector());
+    }
+
+    //compare membership of random addresses against the inputs
+    {
+        quint32 state = 15;
+        auto random = [&state]() {
+            state = state * 1103515245 + 12345;
+            return state >> 8;
+        };
+
+        QVector<NetworkPrefix> prefixesA;
+        QVector<NetworkPrefix> prefixesB;
+        for (int i = 0; i < 2000; ++i) {
+            prefixesA.append(NetworkPrefix::fromIpv4(0x0a000000 | (random() & 0x00ffffff),
+                                                     12 + static_cast<int>(random() % 13)));
+            prefixesB.append(NetworkPrefix::fromIpv4(0x0a000000 | (random() & 0x00ffffff),
+                                                     12 + static_cast<int>(random() % 13)));
+        }
+        NetworkPrefixSet a = NetworkPrefixSet::fromVector(prefixesA);
+        NetworkPrefixSet b = NetworkPrefixSet::fromVector(prefixesB);
+
+        NetworkPrefixSet united = NetworkPrefixSet::unite(a, b);
+        NetworkPrefixSet intersected = NetworkPrefixSet::intersect(a, b);
+        NetworkPrefixSet subtracted = NetworkPrefixSet::subtract(a, b);
+        NetworkPrefixSet difference = NetworkPrefixSet::symmetricDifference(a, b);
+
+        for (int i = 0; i < 5000; ++i) {
+            QHostAddress address(0x0a000000 | (random() & 0x00ffffff));
+            const bool inA = a.longestPrefixMatch(address).isValid();
+            const bool inB = b.longestPrefixMatch(address).isValid();
+            QVERIFY(united.longestPrefixMatch(address).isValid() == (inA || inB));
+            QVERIFY(intersected.longestPrefixMatch(address).isValid() == (inA && inB));
+            QVERIFY(subtracted.longestPrefixMatch(address).isValid() == (inA && !inB));
+            QVERIFY(difference.longestPrefixMatch(address).isValid() == (inA != inB));
+        }
+
+        QVERIFY(NetworkPrefixSet::aggregate(united).toVector() == united.toVector());
+    }
+}
+
+void networkprefixset::coverage()
+{
+    //overlaps and duplicates count once, unlike in addressCount()
+    {
+        NetworkPrefixSet prefixSet;
+        prefixSet.addPrefix(NetworkPrefix("10.0.0.0/8"));
+        prefixSet.addPrefix(NetworkPrefix("10.1.0.0/16"));
+        prefixSet.addPrefix(NetworkPrefix("10.0.0.0/8"));
+        prefixSet.addPrefix(NetworkPrefix("11.0.0.0/24"));
+        prefixSet.addPrefix(NetworkPrefix("2a03:4567::/32"));
+        prefixSet.addPrefix(NetworkPrefix("2a03:4567:1::/48"));
+
+        QVERIFY(prefixSet.addressCount()
+                == UInt128(2 * 16777216 + 65536 + 256) + (UInt128(1) << 96) + (UInt128(1) << 80));
+        QVERIFY(prefixSet.coveredAddressCount(QAbstractSocket::IPv4Protocol) == 16777216 + 256);
+        QVERIFY(prefixSet.coveredAddressCount(QAbstractSocket::IPv6Protocol) == UInt128(1) << 96);
+        QVERIFY(prefixSet.coveredAddressCount(QAbstractSocket::UnknownNetworkLayerProtocol) == 0);
+
+        //changes drop the cached numbers, copies keep their own
+        const NetworkPrefixSet copy = prefixSet;
+        prefixSet.addPrefix(NetworkPrefix("11.0.1.0/24"));
+        QVERIFY(prefixSet.coveredAddressCount(QAbstractSocket::IPv4Protocol) == 16777216 + 512);
+        prefixSet.removePrefix(NetworkPrefix("10.0.0.0/8"), true);
+        QVERIFY(prefixSet.coveredAddressCount(QAbstractSocket::IPv4Protocol) == 65536 + 512);
+        QVERIFY(copy.coveredAddressCount(QAbstractSocket::IPv4Protocol) == 16777216 + 256);
+
+        prefixSet.clear();
+        QVERIFY(prefixSet.coveredAddressCount(QAbstractSocket::IPv6Protocol) == 0);
+    }
+
+    //the whole address space saturates, and on a random set the count agrees
+    //with the aggregated set
+    {
+        NetworkPrefixSet prefixSet;
+        prefixSet.addPrefix(NetworkPrefix("::/0"));
+        prefixSet.addPrefix(NetworkPrefix("::/1"));
+        QVERIFY(prefixSet.coveredAddressCount(QAbstractSocket::IPv6Protocol) == UInt128::max());
+
+        quint32 state = 7;
+        auto next = [&state]() {
+            state = state * 1103515245 + 12345;
+            return state;
+        };
+
+        prefixSet.clear();
+        for (int i = 0; i < 2000; ++i) {
+            prefixSet.addPrefix(NetworkPrefix::fromIpv4(next() & 0x00ffffff, 12 + next() % 20));
+        }
+
+        const NetworkPrefixSet aggregated = NetworkPrefixSet::aggregate(prefixSet);
+        QVERIFY(prefixSet.coveredAddressCount(QAbstractSocket::IPv4Protocol) == aggregated.addressCount());
+    }
+}
+
+void networkprefixset::binaryFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath("prefixes.bin");
+
+    //lookups on the mapped file agree with the set it was saved from
+    {
+        NetworkPrefixSet prefixSet = NetworkPrefixSet::fromFile(":/tst_input_correct.txt");
+        prefixSet.addPrefix(NetworkPrefix("10.0.0.0/8"));
+        prefixSet.addPrefix(NetworkPrefix("10.1.0.0/16"));
+        prefixSet.addPrefix(NetworkPrefix("10.1.2.0/24"));
+        prefixSet.addPrefix(NetworkPrefix("10.1.2.0/24"));
+        prefixSet.addPrefix(NetworkPrefix("10.2.0.0/16"));
+        prefixSet.addPrefix(NetworkPrefix("2001:db8::/32"));
+        prefixSet.addPrefix(NetworkPrefix("2001:db8:1::/48"));
+        QVERIFY(prefixSet.toBinaryFile(fileName));
+
+        NetworkPrefixSetFile file;
+        QVERIFY(file.open(fileName));
+        QVERIFY(file.prefixCount() == prefixSet.prefixCount() - 1);
+        QVERIFY(file.prefixAt(0).isIpv4());
+        QVERIFY(file.prefixAt(file.prefixCount() - 1).isIpv6());
+        QVERIFY(!file.prefixAt(file.prefixCount()).isValid());
+
+        const QStringList addresses = {"10.1.2.3", "10.1.3.3", "10.2.255.255", "10.3.0.1",
+                                       "11.0.0.1", "0.0.0.0", "2001:db8:1::1", "2001:db8:2::1",
+                                       "2001:db9::1", "::"};
+        for (const QString &address : addresses) {
+            QVERIFY(file.longestPrefixMatch(QHostAddress(address))
+                    == prefixSet.longestPrefixMatch(QHostAddress(address)));
+        }
+        QVERIFY(file.longestPrefixMatch(QHostAddress("10.1.2.3")) == NetworkPrefix("10.1.2.0/24"));
+
+        for (const NetworkPrefix &prefix : prefixSet.toVector()) {
+            QVERIFY(file.contains(prefix));
+        }
+        QVERIFY(!file.contains(NetworkPrefix("10.1.0.0/17")));
+        QVERIFY(!file.contains(NetworkPrefix("10.0.0.0/7")));
+
+        NetworkPrefixSet loaded = NetworkPrefixSet::fromBinaryFile(fileName);
+        QVERIFY(loaded.prefixCount() == file.prefixCount());
+        for (const NetworkPrefix &prefix : prefixSet.toVector()) {
+            QVERIFY(loaded.contains(prefix));
+        }
+    }
+
+    //files that are not ours are rejected
+    {
+        NetworkPrefixSetFile file;
+        QVERIFY(!file.open(dir.filePath("missing.bin")));
+        QVERIFY(!file.open(":/tst_input_correct.txt"));
+        QVERIFY(!file.isOpen());
+        QVERIFY(!file.longestPrefixMatch(QHostAddress("10.1.2.3")).isValid());
+
+        QFile truncated(fileName);
+        QVERIFY(truncated.open(QIODevice::ReadOnly));
+        const QByteArray data = truncated.readAll();
+        truncated.close();
+
+        QFile broken(dir.filePath("broken.bin"));
+        QVERIFY(broken.open(QIODevice::WriteOnly));
+        broken.write(data.left(data.size() - 1));
+        broken.close();
+        QVERIFY(!file.open(dir.filePath("broken.bin")));
+
+        NetworkPrefixSet empty;
+        QVERIFY(empty.toBinaryFile(dir.filePath("empty.bin")));
+        QVERIFY(file.open(dir.filePath("empty.bin")));
+        QVERIFY(file.prefixCount() == 0);
+        QVERIFY(!file.longestPrefixMatch(QHostAddress("10.1.2.3")).isValid());
+    }
+
+    //a corrupt parent index neither reads past the records nor loops
+    {
+        NetworkPrefixSet prefixSet;
+        prefixSet.addPrefix(NetworkPrefix("10.0.0.0/8"));
+        prefixSet.addPrefix(NetworkPrefix("10.1.0.0/16"));
+        QVERIFY(prefixSet.toBinaryFile(fileName));
+
+        QFile saved(fileName);
+        QVERIFY(saved.open(QIODevice::ReadOnly));
+        const QByteArray data = saved.readAll();
+        saved.close();
+
+        //the parent of the second record, 32 header bytes and one 12 byte
+        //record in, 8 bytes into the record
+        const int parentOffset = 32 + 12 + 8;
+        const QList<QByteArray> parents = {QByteArray("\x7f\xff\xff\xff", 4),
+                                           QByteArray("\x00\x00\x00\x01", 4)};
+        for (const QByteArray &parent : parents) {
+            QByteArray corrupt = data;
+            corrupt.replace(parentOffset, 4, parent);
+
+            QFile broken(dir.filePath("corrupt.bin"));
+            QVERIFY(broken.open(QIODevice::WriteOnly));
+            broken.write(corrupt);
+            broken.close();
+
+            NetworkPrefixSetFile file;
+            QVERIFY(file.open(dir.filePath("corrupt.bin")));
+            QVERIFY(file.longestPrefixMatch(QHostAddress("10.1.2.3")) == NetworkPrefix("10.1.0.0/16"));
+            QVERIFY(!file.longestPrefixMatch(QHostAddress("10.2.0.1")).isValid());
+            QVERIFY(file.contains(NetworkPrefix("10.1.0.0/16")));
+        }
+
+        //a length out of range skips the record, its parent still matches
+        QByteArray corrupt = data;
+        corrupt[32 + 12 + 4] = static_cast<char>(200);
+
+        QFile broken(dir.filePath("corrupt.bin"));
+        QVERIFY(broken.open(QIODevice::WriteOnly));
+        broken.write(corrupt);
+        broken.close();
+
+        NetworkPrefixSetFile file;
+        QVERIFY(file.open(dir.filePath("corrupt.bin")));
+        QVERIFY(file.longestPrefixMatch(QHostAddress("10.1.2.3")) == NetworkPrefix("10.0.0.0/8"));
+        QVERIFY(!file.contains(NetworkPrefix("10.1.0.0/16")));
+        QVERIFY(!file.prefixAt(1).isValid());
+        QVERIFY(file.toSet().prefixCount() == 1);
+    }
+}
+
+void networkprefixset::streaming()
+{
+    NetworkPrefixSet prefixSet = NetworkPrefixSet::fromFile(":/tst_input_with_duplicates.txt", false, true);
+    prefixSet.addPrefix(NetworkPrefix("2001:db8::/32"));
+
+    QByteArray data;
+    {
+        QDataStream stream(&data, QIODevice::WriteOnly);
+        stream << prefixSet << NetworkPrefixSet();
+    }
+
+    {
+        QDataStream stream(data);
+        NetworkPrefixSet streamed;
+        NetworkPrefixSet empty;
+        stream >> streamed >> empty;
+        QVERIFY(stream.status() == QDataStream::Ok);
+        QVERIFY(streamed.toVector() == prefixSet.toVector());
+        QVERIFY(streamed.contains(NetworkPrefix("2001:db8::/32")));
+        QVERIFY(empty.toVector().isEmpty());
+    }
+
+    //a count that does not fit the block
+    {
+        QByteArray broken = data;
+        broken[3] = static_cast<char>(broken[3] + 1);
+        QDataStream stream(broken);
+        NetworkPrefixSet streamed;
+        stream >> streamed;
+        QVERIFY(stream.status() != QDataStream::Ok);
+        QVERIFY(streamed.toVector().isEmpty());
+    }
+}
+
+void networkprefixset::concurrentUpdates()
+{
+    {
+        NetworkPrefixSet initial;
+        initial.addPrefix(NetworkPrefix("10.0.0.0/8"));
+        ConcurrentNetworkPrefixSet prefixSet(initial);
+        ConcurrentNetworkPrefixSet::Reader reader(&prefixSet);
+
+        QSharedPointer<const NetworkPrefixSet> before = prefixSet.snapshot();
+        QVERIFY(prefixSet.version() == 0);
+
+        prefixSet.update([](NetworkPrefixSet &next) { next.addPrefix(NetworkPrefix("10.1.0.0/16")); });
+        QVERIFY(prefixSet.version() == 1);
+        QVERIFY(reader.longestPrefixMatch(QHostAddress("10.1.2.3")) == NetworkPrefix("10.1.0.0/16"));
+
+        //older snapshots stay as they were
+        QVERIFY(before->prefixCount() == 1);
+        QVERIFY(before->longestPrefixMatch(QHostAddress("10.1.2.3")) == NetworkPrefix("10.0.0.0/8"));
+
+        prefixSet.publish(NetworkPrefixSet());
+        QVERIFY(prefixSet.version() == 2);
+        QVERIFY(!reader.longestPrefixMatch(QHostAddress("10.1.2.3")).isValid());
+        QVERIFY(!reader.contains(NetworkPrefix("10.0.0.0/8")));
+    }
+
+    //readers only ever see complete versions while a writer keeps publishing;
+    //every version holds the /16 and one longer prefix at 10.0.0.0
+    {
+        NetworkPrefixSet initial;
+        initial.addPrefix(NetworkPrefix("10.0.0.0/16"));
+        initial.addPrefix(NetworkPrefix("10.0.0.0/24"));
+        ConcurrentNetworkPrefixSet prefixSet(initial);
+
+        auto read = [&prefixSet]() {
+            ConcurrentNetworkPrefixSet::Reader reader(&prefixSet);
+            for (int i = 0; i < 20000; ++i) {
+                const NetworkPrefixSet &current = reader.current();
+                const NetworkPrefix longest = current.longestPrefixMatch(QHostAddress("10.0.0.1"));
+                if (current.prefixCount() != 2 || !longest.isValid()
+                    || !current.contains(NetworkPrefix::fromIpv4(0x0a000000, 16))) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        QVector<QFuture<bool>> readers;
+        for (int i = 0; i < 4; ++i) {
+            readers.append(QtConcurrent::run(read));
+        }
+
+        for (int i = 1; i <= 200; ++i) {
+            prefixSet.update([i](NetworkPrefixSet &next) {
+                next.clear();
+                next.addPrefix(NetworkPrefix("10.0.0.0/16"));
+                next.addPrefix(NetworkPrefix::fromIpv4(0x0a000000, 24 + i % 9));
+            });
+        }
+
+        for (const QFuture<bool> &future : readers) {
+            QVERIFY(future.result());
+        }
+        QVERIFY(prefixSet.version() == 200);
+    }
+}
+
+void networkprefixset::prefixMap()
+{
+    NetworkPrefixMap<QString> map;
+    map.insert(NetworkPrefix("10.0.0.0/8"), "AS1");
+    map.insert(NetworkPrefix("10.1.0.0/16"), "AS2");
+    map.insert(NetworkPrefix("2001:db8::/32"), "AS3");
+    map.insert(NetworkPrefix("0.0.0.0/0"), "default");
+    map.insert(NetworkPrefix("10.1.0.0/16"), "AS4");
+    map.insert(NetworkPrefix(), "invalid");
+    QVERIFY(map.count() == 4);
+
+    //exact lookups
+    QVERIFY(map.value(NetworkPrefix("10.1.0.0/16")) == "AS4");
+    QVERIFY(map.value(NetworkPrefix("10.2.0.0/16"), "none") == "none");
+    QVERIFY(map.contains(NetworkPrefix("2001:db8::/32")));
+    QVERIFY(!map.find(NetworkPrefix("10.0.0.0/9")));
+    *map.find(NetworkPrefix("10.0.0.0/8")) = "AS5";
+    map[NetworkPrefix("192.168.0.0/16")] = "private";
+    QVERIFY(map.value(NetworkPrefix("10.0.0.0/8")) == "AS5");
+    QVERIFY(map.value(NetworkPrefix("192.168.0.0/16")) == "private");
+
+    //an invalid prefix gets a spare value and never becomes a key
+    QTest::ignoreMessage(QtWarningMsg, "NetworkPrefixMap: an invalid prefix cannot be a key");
+    map[NetworkPrefix()] = "invalid";
+    QTest::ignoreMessage(QtWarningMsg, "NetworkPrefixMap: an invalid prefix cannot be a key");
+    QVERIFY(map[NetworkPrefix()].isEmpty());
+    QVERIFY(!map.contains(NetworkPrefix()));
+    QVERIFY(!map.find(NetworkPrefix()));
+    QVERIFY(map.count() == 5);
+
+    //longest prefix match
+    NetworkPrefix matched;
+    QVERIFY(*map.longestPrefixMatch(QHostAddress("10.1.2.3"), &matched) == "AS4");
+    QVERIFY(matched == NetworkPrefix("10.1.0.0/16"));
+    QVERIFY(*map.longestPrefixMatch(QHostAddress("10.2.2.3")) == "AS5");
+    QVERIFY(*map.longestPrefixMatch(QHostAddress("11.2.2.3")) == "default");
+    QVERIFY(*map.longestPrefixMatch(QHostAddress("2001:db8::1")) == "AS3");
+    QVERIFY(!map.longestPrefixMatch(QHostAddress("2001:db9::1")));
+
+    //iteration in prefix order
+    const QVector<NetworkPrefix> expected = {NetworkPrefix("0.0.0.0/0"),
+                                             NetworkPrefix("10.0.0.0/8"),
+                                             NetworkPrefix("10.1.0.0/16"),
+                                             NetworkPrefix("192.168.0.0/16"),
+                                             NetworkPrefix("2001:db8::/32")};
+    QVERIFY(map.keys() == expected);
+
+    QStringList values;
+    for (auto it = map.begin(); it != map.end(); ++it) {
+        values.append(it.value());
+    }
+    QVERIFY(values == (QStringList{"default", "AS5", "AS4", "private", "AS3"}));
+
+    //removing moves the last value into the hole, lookups keep working
+    QVERIFY(map.remove(NetworkPrefix("0.0.0.0/0")));
+    QVERIFY(!map.remove(NetworkPrefix("0.0.0.0/0")));
+    QVERIFY(map.count() == 4);
+    QVERIFY(!map.longestPrefixMatch(QHostAddress("11.2.2.3")));
+    QVERIFY(*map.longestPrefixMatch(QHostAddress("192.168.1.1")) == "private");
+    QVERIFY(*map.longestPrefixMatch(QHostAddress("10.1.2.3")) == "AS4");
+    QVERIFY(map.keys() == expected.mid(1));
+
+    map.clear();
+    QVERIFY(map.isEmpty());
+    QVERIFY(map.begin() == map.end());
+}
+
+void networkprefixset::batchLookup()
+{
+    quint32 state = 20;
+    auto random = [&state]() {
+        state = state * 1103515245 + 12345;
+        return state >> 8;
+    };
+
+    NetworkPrefixSet prefixSet;
+    for (int i = 0; i < 5000; ++i) {
+        prefixSet.addPrefix(NetworkPrefix::fromIpv4(0x0a000000 | (random() & 0x000fffff) << 4,
+                                                    8 + static_cast<int>(random() % 25)));
+        Q_IPV6ADDR bytes = {};
+        bytes.c[0] = 0x20;
+        bytes.c[1] = 0x01;
+        bytes.c[2] = static_cast<quint8>(random());
+        bytes.c[3] = static_cast<quint8>(random());
+        prefixSet.addPrefix(NetworkPrefix(QHostAddress(bytes), 16 + static_cast<int>(random() % 32)));
+    }
+
+    //not a multiple of the number of interleaved lookups
+    const int count = 1000;
+    QVector<quint32> ipv4Addresses(count);
+    QVector<Q_IPV6ADDR> ipv6Addresses(count);
+    for (int i = 0; i < count; ++i) {
+        ipv4Addresses[i] = 0x0a000000 | (random() & 0x000fffff) << 4 | (i & 0xf);
+        Q_IPV6ADDR bytes = {};
+        bytes.c[0] = i % 7 == 0 ? 0x30 : 0x20;
+        bytes.c[1] = 0x01;
+        bytes.c[2] = static_cast<quint8>(random());
+        bytes.c[3] = static_cast<quint8>(random());
+        bytes.c[15] = static_cast<quint8>(i);
+        ipv6Addresses[i] = bytes;
+    }
+
+    QVector<NetworkPrefix> ipv4Matches(count);
+    QVector<NetworkPrefix> ipv6Matches(count);
+    prefixSet.longestPrefixMatches(ipv4Addresses.constData(), count, ipv4Matches.data());
+    prefixSet.longestPrefixMatches(ipv6Addresses.constData(), count, ipv6Matches.data());
+
+    int found = 0;
+    for (int i = 0; i < count; ++i) {
+        QVERIFY(ipv4Matches[i] == prefixSet.longestPrefixMatch(QHostAddress(ipv4Addresses[i])));
+        QVERIFY(ipv6Matches[i] == prefixSet.longestPrefixMatch(QHostAddress(ipv6Addresses[i])));
+        found += ipv4Matches[i].isValid() + ipv6Matches[i].isValid();
+    }
+    QVERIFY(found > 0);
+
+    //nothing to match against
+    NetworkPrefixSet empty;
+    empty.longestPrefixMatches(ipv4Addresses.constData(), count, ipv4Matches.data());
+    QVERIFY(!ipv4Matches.first().isValid() && !ipv4Matches.last().isValid());
+}
+
 QTEST_APPLESS_MAIN(networkprefixset)
 
 #include "tst_networkprefixset.moc"